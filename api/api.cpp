@@ -13,6 +13,12 @@
 #define OIDN_LOCK_DEVICE(obj) \
   DeviceGuard deviceGuard(obj);
 
+// Locks only the stream of the specified filter if the device has multiple streams, otherwise
+// the whole device, and saves/restores state
+// Use *only* inside OIDN_TRY/CATCH!
+#define OIDN_LOCK_STREAM(filter) \
+  StreamGuard streamGuard(filter);
+
 // Try/catch for converting exceptions to errors
 #define OIDN_TRY \
   try {
@@ -47,6 +53,15 @@ OIDN_API_NAMESPACE_BEGIN
       : device(obj->getDevice()),
         lock(device->getMutex())
     {
+      // Wait for the concurrent filter executions to finish submitting, if there are multiple
+      // streams, so the shared device state is never modified while being accessed
+      const int numStreams = device->getNumStreams();
+      if (numStreams > 1)
+      {
+        for (int i = 0; i < numStreams; ++i)
+          streamLocks.emplace_back(device->getStreamMutex(i));
+      }
+
       device->enter(); // save state
     }
 
@@ -66,6 +81,44 @@ OIDN_API_NAMESPACE_BEGIN
 
     Ref<Device> device;               // ref needed to keep the device alive
     std::lock_guard<std::mutex> lock; // must be declared *after* the device
+    std::vector<std::unique_lock<std::mutex>> streamLocks; // must be declared *after* the lock
+  };
+
+  class StreamGuard
+  {
+  public:
+    StreamGuard(Filter* filter)
+      : device(filter->getDevice())
+    {
+      // Filters in different streams can be executed concurrently
+      if (device->getNumStreams() > 1)
+      {
+        lock = std::unique_lock<std::mutex>(device->getStreamMutex(filter->getStreamID()));
+        device->setStream(filter->getStreamID());
+      }
+      else
+        lock = std::unique_lock<std::mutex>(device->getMutex());
+
+      device->enter(); // save state
+    }
+
+    ~StreamGuard()
+    {
+      try
+      {
+        device->leave(); // restore state
+        device->setStream(-1);
+      }
+      catch (...) {}
+    }
+
+  private:
+    // Disable copying
+    StreamGuard(const StreamGuard&) = delete;
+    StreamGuard& operator =(const StreamGuard&) = delete;
+
+    Ref<Device> device;                // ref needed to keep the device alive
+    std::unique_lock<std::mutex> lock; // must be declared *after* the device
   };
 
   namespace
@@ -422,6 +475,17 @@ OIDN_API_NAMESPACE_BEGIN
     return reinterpret_cast<OIDNDevice>(device.detach());
   }
 
+  OIDN_API OIDNDevice oidnNewCPUDevice(void* const* taskArenas, int numArenas)
+  {
+    Ref<Device> device = nullptr;
+    OIDN_TRY
+      OIDN_INIT_CONTEXT(ctx, DeviceType::CPU);
+      auto factory = static_cast<CPUDeviceFactoryBase*>(ctx.getDeviceFactory(DeviceType::CPU));
+      device = factory->newDevice(taskArenas, numArenas);
+    OIDN_CATCH
+    return reinterpret_cast<OIDNDevice>(device.detach());
+  }
+
   OIDN_API OIDNDevice oidnNewCUDADevice(const int* deviceIDs, const cudaStream_t* streams, int numPairs)
   {
     Ref<Device> device = nullptr;
@@ -489,6 +553,17 @@ OIDN_API_NAMESPACE_BEGIN
     OIDN_CATCH_DEVICE(device)
   }
 
+  OIDN_API void oidnSetDeviceString(OIDNDevice hDevice, const char* name, const char* value)
+  {
+    Device* device = reinterpret_cast<Device*>(hDevice);
+    OIDN_TRY
+      checkHandle(hDevice);
+      OIDN_LOCK_DEVICE(device);
+      checkString(name);
+      device->setString(name, value ? value : "");
+    OIDN_CATCH_DEVICE(device)
+  }
+
   OIDN_API bool oidnGetDeviceBool(OIDNDevice hDevice, const char* name)
   {
     Device* device = reinterpret_cast<Device*>(hDevice);
@@ -513,6 +588,18 @@ OIDN_API_NAMESPACE_BEGIN
     return 0;
   }
 
+  OIDN_API const char* oidnGetDeviceString(OIDNDevice hDevice, const char* name)
+  {
+    Device* device = reinterpret_cast<Device*>(hDevice);
+    OIDN_TRY
+      checkHandle(hDevice);
+      OIDN_LOCK_DEVICE(device);
+      checkString(name);
+      return device->getString(name);
+    OIDN_CATCH_DEVICE(device)
+    return nullptr;
+  }
+
   OIDN_API void oidnSetDeviceErrorFunction(OIDNDevice hDevice, OIDNErrorFunction func, void* userPtr)
   {
     Device* device = reinterpret_cast<Device*>(hDevice);
@@ -801,6 +888,23 @@ OIDN_API_NAMESPACE_BEGIN
     OIDN_CATCH_DEVICE(filter)
   }
 
+  OIDN_API void oidnSetFilterImageStream(OIDNFilter hFilter, const char* name,
+                                         OIDNImageStreamFunction func, void* userPtr,
+                                         OIDNFormat format, size_t width, size_t height)
+  {
+    Filter* filter = reinterpret_cast<Filter*>(hFilter);
+    OIDN_TRY
+      checkHandle(hFilter);
+      OIDN_LOCK_DEVICE(filter);
+      checkString(name);
+      if (!func)
+        throw Exception(Error::InvalidArgument, "image stream function is null");
+      auto image = makeRef<Image>(ImageStream{func, userPtr}, static_cast<Format>(format),
+                                  static_cast<int>(width), static_cast<int>(height));
+      filter->setImage(name, image);
+    OIDN_CATCH_DEVICE(filter)
+  }
+
   OIDN_API void oidnUnsetFilterImage(OIDNFilter hFilter, const char* name)
   {
     Filter* filter = reinterpret_cast<Filter*>(hFilter);
@@ -927,6 +1031,17 @@ OIDN_API_NAMESPACE_BEGIN
     OIDN_CATCH_DEVICE(filter)
   }
 
+  OIDN_API void oidnSetFilterProfilingFunction(OIDNFilter hFilter,
+                                               OIDNProfilingFunction func, void* userPtr)
+  {
+    Filter* filter = reinterpret_cast<Filter*>(hFilter);
+    OIDN_TRY
+      checkHandle(hFilter);
+      OIDN_LOCK_DEVICE(filter);
+      filter->setProfilingFunction(func, userPtr);
+    OIDN_CATCH_DEVICE(filter)
+  }
+
   OIDN_API void oidnCommitFilter(OIDNFilter hFilter)
   {
     Filter* filter = reinterpret_cast<Filter*>(hFilter);
@@ -942,7 +1057,7 @@ OIDN_API_NAMESPACE_BEGIN
     Filter* filter = reinterpret_cast<Filter*>(hFilter);
     OIDN_TRY
       checkHandle(hFilter);
-      OIDN_LOCK_DEVICE(filter);
+      OIDN_LOCK_STREAM(filter);
       filter->execute();
     OIDN_CATCH_DEVICE(filter)
   }
@@ -952,7 +1067,7 @@ OIDN_API_NAMESPACE_BEGIN
     Filter* filter = reinterpret_cast<Filter*>(hFilter);
     OIDN_TRY
       checkHandle(hFilter);
-      OIDN_LOCK_DEVICE(filter);
+      OIDN_LOCK_STREAM(filter);
       filter->execute(SyncMode::Async);
     OIDN_CATCH_DEVICE(filter)
   }
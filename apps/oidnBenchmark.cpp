@@ -8,6 +8,7 @@
 #include "utils/device_info.h"
 #include "utils/random.h"
 #include <iostream>
+#include <fstream>
 #include <cassert>
 #include <cmath>
 #include <regex>
@@ -28,6 +29,12 @@ bool bufferCopy = false; // include copying between host and device in the measu
 int numRuns = 0;
 int maxMemoryMB = -1;
 bool inplace = false;
+int batchSize = 1;
+bool autotune = false; // select the fastest tile size when committing the filter
+bool temporalAutoexposure = false; // reuse the autoexposure of the previous execution for HDR images
+bool submitOnly = false; // measure the host-side submission overhead using small images
+const int submitDepth = 16; // number of executions submitted without synchronization in submit mode
+std::string profileFilename; // per-operation profile output (JSON)
 
 void printUsage()
 {
@@ -36,8 +43,9 @@ void printUsage()
             << "                     [-r/--run regex] [-n times_to_run]" << std::endl
             << "                     [-s/--size width height]" << std::endl
             << "                     [-t/--type float|half]" << std::endl
-            << "                     [-q/--quality default|h|high|b|balanced|f|fast]" << std::endl
+            << "                     [-q/--quality default|h|high|b|balanced|f|fast|p|preview]" << std::endl
             << "                     [--threads n] [--affinity 0|1] [--maxmem MB] [--inplace]" << std::endl
+            << "                     [-b/--batch n] [--tune] [--temporal] [--profile file.json] [--submit]" << std::endl
             << "                     [--buffer host(copy)|device(copy)|managed(copy)]" << std::endl
             << "                     [-v/--verbose 0-3]" << std::endl
             << "                     [--ld|--list_devices] [-l/--list] [-h/--help]" << std::endl;
@@ -56,6 +64,7 @@ struct Benchmark
   std::vector<std::string> inputs;
   int width;
   int height;
+  int batchSize; // number of images stacked vertically
 
   bool hasInput(const std::string& input) const
   {
@@ -66,8 +75,97 @@ struct Benchmark
 // List of all benchmarks
 std::vector<Benchmark> benchmarks;
 
+// Per-operation profile of a benchmark, accumulated over the benchmark runs
+struct BenchmarkProfile
+{
+  struct Op
+  {
+    std::string name;
+    std::string type;
+    int count = 0;
+    double time = 0;
+    size_t bytesRead = 0;
+    size_t bytesWritten = 0;
+    size_t flops = 0;
+  };
+
+  std::string name;
+  int numRuns = 0;
+  std::vector<Op> ops;
+};
+
+std::vector<BenchmarkProfile> profiles;
+
+void profilingCallback(void* userPtr, const ProfileRecord* records, int numRecords)
+{
+  BenchmarkProfile& profile = *static_cast<BenchmarkProfile*>(userPtr);
+  profile.numRuns++;
+
+  for (int i = 0; i < numRecords; ++i)
+  {
+    const ProfileRecord& record = records[i];
+    auto opIter = std::find_if(profile.ops.begin(), profile.ops.end(),
+                               [&](const BenchmarkProfile::Op& op) { return op.name == record.name; });
+    if (opIter == profile.ops.end())
+    {
+      profile.ops.emplace_back();
+      opIter = profile.ops.end() - 1;
+      opIter->name = record.name;
+      opIter->type = record.type;
+    }
+
+    opIter->count += record.count;
+    opIter->time  += record.time;
+    opIter->bytesRead    += record.bytesRead;
+    opIter->bytesWritten += record.bytesWritten;
+    opIter->flops        += record.flops;
+  }
+}
+
+// Writes the profiles of all benchmarks to a JSON file, averaging the values over the runs
+void writeProfiles(const std::string& filename)
+{
+  std::ofstream file(filename);
+  if (!file)
+    throw std::runtime_error("cannot open profile output file: '" + filename + "'");
+
+  file << "{" << std::endl;
+  file << "  \"benchmarks\": [" << std::endl;
+  for (size_t i = 0; i < profiles.size(); ++i)
+  {
+    const auto& profile = profiles[i];
+    const double runs = std::max(profile.numRuns, 1);
+    double totalTime = 0;
+
+    file << "    {" << std::endl;
+    file << "      \"name\": \"" << profile.name << "\"," << std::endl;
+    file << "      \"runs\": " << profile.numRuns << "," << std::endl;
+    file << "      \"ops\": [" << std::endl;
+    for (size_t j = 0; j < profile.ops.size(); ++j)
+    {
+      const auto& op = profile.ops[j];
+      totalTime += op.time;
+      file << "        {"
+           << "\"name\": \"" << op.name << "\", "
+           << "\"type\": \"" << op.type << "\", "
+           << "\"count\": " << op.count / runs << ", "
+           << "\"msec\": " << op.time / runs * 1000 << ", "
+           << "\"bytesRead\": " << op.bytesRead / runs << ", "
+           << "\"bytesWritten\": " << op.bytesWritten / runs << ", "
+           << "\"flops\": " << op.flops / runs
+           << "}" << (j + 1 < profile.ops.size() ? "," : "") << std::endl;
+    }
+    file << "      ]," << std::endl;
+    file << "      \"msec\": " << totalTime / runs * 1000 << std::endl;
+    file << "    }" << (i + 1 < profiles.size() ? "," : "") << std::endl;
+  }
+  file << "  ]" << std::endl;
+  file << "}" << std::endl;
+}
+
 // Adds a benchmark to the list
-void addBenchmark(const std::string& filter, const std::vector<std::string>& inputs, const std::pair<int, int>& size)
+void addBenchmark(const std::string& filter, const std::vector<std::string>& inputs, const std::pair<int, int>& size,
+                  int batchSize = 1)
 {
   Benchmark bench;
   bench.name = filter;
@@ -78,11 +176,14 @@ void addBenchmark(const std::string& filter, const std::vector<std::string>& inp
     bench.name += inputs[i];
   }
   bench.name += "." + toString(size.first) + "x" + toString(size.second);
+  if (batchSize > 1)
+    bench.name += "x" + toString(batchSize);
 
   bench.filter = filter;
   bench.inputs = inputs;
   bench.width  = size.first;
   bench.height = size.second;
+  bench.batchSize = batchSize;
 
   benchmarks.push_back(bench);
 }
@@ -109,38 +210,41 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
   FilterRef filter = device.newFilter(bench.filter.c_str());
   Random rng;
 
+  // The images in the batch are stacked vertically
+  const int batchHeight = bench.height * bench.batchSize;
+
   std::shared_ptr<ImageBuffer> input;
 
   std::shared_ptr<ImageBuffer> albedo;
   if (bench.hasInput("alb") || bench.hasInput("calb"))
   {
-    input = albedo = newImage(device, bench.width, bench.height);
+    input = albedo = newImage(device, bench.width, batchHeight);
     initImage(*albedo, rng, 0.f, 1.f);
-    filter.setImage("albedo", albedo->getBuffer(), albedo->getFormat(), bench.width, bench.height);
+    filter.setImage("albedo", albedo->getBuffer(), albedo->getFormat(), bench.width, batchHeight);
   }
 
   std::shared_ptr<ImageBuffer> normal;
   if (bench.hasInput("nrm") || bench.hasInput("cnrm"))
   {
-    input = normal = newImage(device, bench.width, bench.height);
+    input = normal = newImage(device, bench.width, batchHeight);
     initImage(*normal, rng, -1.f, 1.f);
-    filter.setImage("normal", normal->getBuffer(), normal->getFormat(), bench.width, bench.height);
+    filter.setImage("normal", normal->getBuffer(), normal->getFormat(), bench.width, batchHeight);
   }
 
   std::shared_ptr<ImageBuffer> color;
   if (bench.hasInput("hdr"))
   {
-    input = color = newImage(device, bench.width, bench.height);
+    input = color = newImage(device, bench.width, batchHeight);
     initImage(*color, rng, 0.f, 100.f);
-    filter.setImage("color", color->getBuffer(), color->getFormat(), bench.width, bench.height);
+    filter.setImage("color", color->getBuffer(), color->getFormat(), bench.width, batchHeight);
     if (bench.filter != "RTLightmap")
       filter.set("hdr", true);
   }
   else if (bench.hasInput("ldr"))
   {
-    input = color = newImage(device, bench.width, bench.height);
+    input = color = newImage(device, bench.width, batchHeight);
     initImage(*color, rng, 0.f, 1.f);
-    filter.setImage("color", color->getBuffer(), color->getFormat(), bench.width, bench.height);
+    filter.setImage("color", color->getBuffer(), color->getFormat(), bench.width, batchHeight);
     filter.set("hdr", false);
   }
 
@@ -151,8 +255,8 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
   if (inplace)
     output = input;
   else
-    output = newImage(device, bench.width, bench.height);
-  filter.setImage("output", output->getBuffer(), output->getFormat(), bench.width, bench.height);
+    output = newImage(device, bench.width, batchHeight);
+  filter.setImage("output", output->getBuffer(), output->getFormat(), bench.width, batchHeight);
 
   if (quality != Quality::Default)
     filter.set("quality", quality);
@@ -160,6 +264,20 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
   if (maxMemoryMB >= 0)
     filter.set("maxMemoryMB", maxMemoryMB);
 
+  if (bench.batchSize > 1)
+    filter.set("batchSize", bench.batchSize);
+
+  if (autotune)
+    filter.set("autotune", true);
+
+  if (temporalAutoexposure && bench.hasInput("hdr"))
+    filter.set("temporalAutoexposure", true);
+
+  // Profile only the benchmark runs, the warmup runs are discarded
+  BenchmarkProfile profile;
+  if (!profileFilename.empty())
+    filter.setProfilingFunction(profilingCallback, &profile);
+
   filter.commit();
 
   auto executeFilterAsync = [&]()
@@ -205,6 +323,9 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
     numBenchmarkRuns = std::max(int(0.5 / warmupTime), 3);
   }
 
+  profile = BenchmarkProfile();
+  profile.name = bench.name;
+
   // Benchmark loop
   Timer timer;
   Timer asyncTimer;
@@ -219,7 +340,11 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
     asyncTimer.reset();
     executeFilterAsync();
     totalAsyncTime += asyncTimer.query();
-    device.sync();
+
+    // In submit mode multiple executions are queued back to back, thus the host time does not
+    // include the synchronization with the device
+    if (!submitOnly || (i + 1) % submitDepth == 0 || i == numBenchmarkRuns - 1)
+      device.sync();
   }
 
   #ifdef VTUNE
@@ -228,11 +353,19 @@ double runBenchmark(DeviceRef& device, const Benchmark& bench)
 
   // Print results
   const double totalTime = timer.query();
-  const double avgTime = totalTime / numBenchmarkRuns;
-  const double avgAsyncTime = totalAsyncTime / numBenchmarkRuns;
-  std::cout << " " << avgTime * 1000 << " msec/image"
-            << " (host " << avgAsyncTime * 1000 << " msec/image)"
-            << std::endl;
+  const double avgTime = totalTime / (numBenchmarkRuns * bench.batchSize);
+  const double avgAsyncTime = totalAsyncTime / (numBenchmarkRuns * bench.batchSize);
+  if (submitOnly)
+    std::cout << " " << avgAsyncTime * 1000000 << " usec/image submit"
+              << " (" << avgTime * 1000 << " msec/image)"
+              << std::endl;
+  else
+    std::cout << " " << avgTime * 1000 << " msec/image"
+              << " (host " << avgAsyncTime * 1000 << " msec/image)"
+              << std::endl;
+
+  if (!profileFilename.empty())
+    profiles.push_back(profile);
 
   return totalTime;
 }
@@ -244,29 +377,37 @@ void addAllBenchmarks()
 
   // Filter: RT
 #if defined(OIDN_FILTER_RT)
-  if (width < 0)
+  if (width < 0 && submitOnly)
+    sizes = {{256, 256}}; // small images to make the submission overhead significant
+  else if (width < 0)
     sizes = {{1920, 1080}, {3840, 2160}, {1280, 720}};
   else
     sizes = {{width, height}};
 
   for (const auto& size : sizes)
   {
-    addBenchmark("RT", {"hdr", "alb", "nrm"}, size);
-    addBenchmark("RT", {"ldr", "alb", "nrm"}, size);
-    addBenchmark("RT", {"hdr", "calb", "cnrm"}, size);
-    addBenchmark("RT", {"ldr", "calb", "cnrm"}, size);
+    addBenchmark("RT", {"hdr", "alb", "nrm"}, size, batchSize);
+    addBenchmark("RT", {"ldr", "alb", "nrm"}, size, batchSize);
+    addBenchmark("RT", {"hdr", "calb", "cnrm"}, size, batchSize);
+    addBenchmark("RT", {"ldr", "calb", "cnrm"}, size, batchSize);
   }
 #endif
 
   // Filter: RTLightmap
 #if defined(OIDN_FILTER_RTLIGHTMAP)
-  if (width < 0)
+  if (width < 0 && submitOnly)
+    sizes = {{256, 256}};
+  else if (width < 0)
     sizes = {{2048, 2048}, {4096, 4096}, {1024, 1024}};
 
   for (const auto& size : sizes)
   {
-    addBenchmark("RTLightmap", {"hdr"}, size);
+    addBenchmark("RTLightmap", {"hdr"}, size, batchSize);
   }
+
+  // Many small lightmaps denoised in batches
+  if (width < 0 && !submitOnly)
+    addBenchmark("RTLightmap", {"hdr"}, {512, 512}, 16);
 #endif
 }
 
@@ -329,6 +470,8 @@ int main(int argc, char* argv[])
           quality = Quality::Balanced;
         else if (val == "f" || val == "fast")
           quality = Quality::Fast;
+        else if (val == "p" || val == "preview")
+          quality = Quality::Preview;
         else
           throw std::runtime_error("invalid filter quality mode");
       }
@@ -340,6 +483,20 @@ int main(int argc, char* argv[])
         maxMemoryMB = args.getNextValue<int>();
       else if (opt == "inplace")
         inplace = true;
+      else if (opt == "b" || opt == "batch")
+      {
+        batchSize = args.getNextValue<int>();
+        if (batchSize < 1)
+          throw std::runtime_error("invalid batch size");
+      }
+      else if (opt == "tune")
+        autotune = true;
+      else if (opt == "temporal")
+        temporalAutoexposure = true;
+      else if (opt == "submit")
+        submitOnly = true;
+      else if (opt == "profile")
+        profileFilename = args.getNextValue();
       else if (opt == "buffer")
       {
         const auto val = toLower(args.getNextValue());
@@ -409,6 +566,8 @@ int main(int argc, char* argv[])
       device.set("numThreads", numThreads);
     if (setAffinity >= 0)
       device.set("setAffinity", bool(setAffinity));
+    if (!profileFilename.empty())
+      device.set("profiling", true); // serializes the operations, which affects the timings
 
     device.commit();
 
@@ -433,6 +592,9 @@ int main(int argc, char* argv[])
         prevBenchTime = runBenchmark(device, bench);
       }
     }
+
+    if (!profileFilename.empty())
+      writeProfiles(profileFilename);
   }
   catch (const std::exception& e)
   {
@@ -25,12 +25,12 @@ void printUsage()
   std::cout << "usage: oidnDenoise [-d/--device [0-9]+|default|cpu|sycl|cuda|hip|metal]" << std::endl
             << "                   [-f/--filter RT|RTLightmap]" << std::endl
             << "                   [--hdr color.pfm] [--ldr color.pfm] [--srgb] [--dir directional.pfm]" << std::endl
-            << "                   [--alb albedo.pfm] [--nrm normal.pfm] [--clean_aux]" << std::endl
+            << "                   [--alb albedo.pfm] [--nrm normal.pfm] [--clean_aux] [--prefilter_aux]" << std::endl
             << "                   [--is/--input_scale value]" << std::endl
             << "                   [-o/--output output.pfm]" << std::endl
             << "                   [-r/--ref reference_output.pfm] [--maxerror e]" << std::endl
             << "                   [-t/--type float|half]" << std::endl
-            << "                   [-q/--quality default|h|high|b|balanced|f|fast]" << std::endl
+            << "                   [-q/--quality default|h|high|b|balanced|f|fast|p|preview]" << std::endl
             << "                   [-w/--weights weights.tza]" << std::endl
             << "                   [--threads n] [--affinity 0|1] [--maxmem MB] [--inplace]" << std::endl
             << "                   [--buffer host|device|managed]" << std::endl
@@ -86,6 +86,7 @@ int main(int argc, char* argv[])
   bool directional = false;
   float inputScale = std::numeric_limits<float>::quiet_NaN();
   bool cleanAux = false;
+  bool prefilterAux = false;
   DataType dataType = DataType::Void;
   int numRuns = 1;
   int numThreads = -1;
@@ -147,6 +148,8 @@ int main(int argc, char* argv[])
         inputScale = args.getNextValue<float>();
       else if (opt == "clean_aux" || opt == "clean-aux" || opt == "cleanAux" || opt == "cleanaux")
         cleanAux = true;
+      else if (opt == "prefilter_aux" || opt == "prefilter-aux" || opt == "prefilterAux" || opt == "prefilteraux")
+        prefilterAux = true;
       else if (opt == "t" || opt == "type")
       {
         const auto val = toLower(args.getNextValue());
@@ -168,6 +171,8 @@ int main(int argc, char* argv[])
           quality = Quality::Balanced;
         else if (val == "f" || val == "fast")
           quality = Quality::Fast;
+        else if (val == "p" || val == "preview")
+          quality = Quality::Preview;
         else
           throw std::runtime_error("invalid filter quality mode");
       }
@@ -353,6 +358,8 @@ int main(int argc, char* argv[])
 
     if (cleanAux)
       filter.set("cleanAux", cleanAux);
+    if (prefilterAux)
+      filter.set("prefilterAux", prefilterAux);
 
     if (quality != Quality::Default)
       filter.set("quality", quality);
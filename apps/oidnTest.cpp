@@ -3,11 +3,22 @@
 
 #include "common/common.h"
 #include "common/timer.h"
+#include "core/arena_planner.h"
 #include "utils/image_buffer.h"
 #include "utils/random.h"
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
 #include <limits>
+#include <sstream>
+#include <thread>
+#if !defined(_WIN32)
+  #include <dirent.h>
+#endif
 
 #define CATCH_CONFIG_RUNNER
 #define CATCH_CONFIG_FAST_COMPILE
@@ -318,6 +329,119 @@ TEST_CASE("buffer read/write", "[buffer_rw]")
 
 // -------------------------------------------------------------------------------------------------
 
+struct PlannedAlloc
+{
+  int id;
+  size_t byteSize;
+  size_t byteAlignment;
+  int firstOpID;
+  int lastOpID;
+};
+
+// Checks that the planned allocations are aligned, fit in the planned size, and do not overlap
+// in memory if they are used at the same time
+void checkArenaPlan(const ArenaPlanner& planner, const std::vector<PlannedAlloc>& allocs)
+{
+  REQUIRE(planner.getByteSize() >= planner.getLowerBoundByteSize());
+
+  for (size_t i = 0; i < allocs.size(); ++i)
+  {
+    const PlannedAlloc& a = allocs[i];
+    const size_t aBegin = planner.getAllocByteOffset(a.id);
+    REQUIRE(aBegin % a.byteAlignment == 0);
+    REQUIRE(aBegin + a.byteSize <= planner.getByteSize());
+
+    for (size_t j = i + 1; j < allocs.size(); ++j)
+    {
+      const PlannedAlloc& b = allocs[j];
+      if (a.lastOpID < b.firstOpID || b.lastOpID < a.firstOpID || a.byteSize == 0 || b.byteSize == 0)
+        continue;
+      const size_t bBegin = planner.getAllocByteOffset(b.id);
+      REQUIRE((aBegin + a.byteSize <= bBegin || bBegin + b.byteSize <= aBegin));
+    }
+  }
+}
+
+TEST_CASE("arena planner", "[arena_planner]")
+{
+  ArenaPlanner planner;
+
+  SECTION("chain")
+  {
+    // Each op reads the output of the previous one, so only two consecutive outputs are alive at
+    // the same time and the memory of the dead ones can be reused
+    const std::array<size_t, 5> byteSizes = {{1024, 4096, 2048, 3072, 512}};
+    std::vector<PlannedAlloc> allocs;
+    for (int opID = 0; opID < int(byteSizes.size()); ++opID)
+    {
+      if (opID > 0)
+        planner.addDepAllocs(opID, {allocs.back().id});
+      const int id = planner.newAlloc(opID, byteSizes[opID], 64);
+      allocs.push_back({id, byteSizes[opID], 64, opID, opID});
+      if (opID > 0)
+        allocs[opID - 1].lastOpID = opID;
+    }
+    planner.commit();
+
+    REQUIRE(planner.getLowerBoundByteSize() == 4096 + 2048);
+    REQUIRE(planner.getByteSize() == planner.getLowerBoundByteSize());
+    checkArenaPlan(planner, allocs);
+  }
+
+  SECTION("concat")
+  {
+    // Two allocations concatenated by a later op must be stored consecutively
+    const int a = planner.newAlloc(0, 1024, 64);
+    const int b = planner.newAlloc(1, 2048, 64);
+    const int c = planner.newAlloc(2, 4096, 64);
+    planner.addDepAllocs(1, {a});
+    planner.addDepAllocs(2, {b});
+    planner.addDepAllocs(3, {a, c}, true);
+    const int d = planner.newAlloc(3, 512, 64);
+    planner.commit();
+
+    REQUIRE(planner.getAllocByteOffset(c) == planner.getAllocByteOffset(a) + 1024);
+    REQUIRE(planner.getLowerBoundByteSize() == 1024 + 2048 + 4096);
+    REQUIRE(planner.getByteSize() == planner.getLowerBoundByteSize());
+    checkArenaPlan(planner, {{a, 1024, 64, 0, 3}, {b, 2048, 64, 1, 2}, {c, 4096, 64, 2, 3},
+                             {d, 512, 64, 3, 3}});
+  }
+
+  SECTION("random")
+  {
+    Random rng;
+    for (int iter = 0; iter < 20; ++iter)
+    {
+      planner.clear();
+      std::vector<PlannedAlloc> allocs;
+      const int numOps = 30;
+      for (int opID = 0; opID < numOps; ++opID)
+      {
+        const size_t byteAlignment = size_t(1) << (4 + rng.getUInt() % 4);
+        const size_t byteSize = (rng.getUInt() % 10000) + 1;
+        const int id = planner.newAlloc(opID, byteSize, byteAlignment);
+        const int lastOpID = min(opID + int(rng.getUInt() % 6), numOps - 1);
+        if (lastOpID > opID)
+          planner.addDepAllocs(lastOpID, {id});
+        allocs.push_back({id, byteSize, byteAlignment, opID, lastOpID});
+      }
+
+      // Some allocations turn out to be unnecessary
+      for (int k = 0; k < 3; ++k)
+      {
+        PlannedAlloc& alloc = allocs[rng.getUInt() % allocs.size()];
+        alloc.byteSize = 0;
+        planner.setAllocByteSize(alloc.id, 0);
+      }
+
+      planner.commit();
+      checkArenaPlan(planner, allocs);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
 #if defined(OIDN_FILTER_RT)
 
 void setFilterImage(FilterRef& filter, const char* name, const std::shared_ptr<ImageBuffer>& image,
@@ -356,6 +480,26 @@ std::shared_ptr<ImageBuffer> makeRandomImage(DeviceRef& device, int W, int H, in
   return image;
 }
 
+// Makes a random HDR image whose autoexposure input scale is known: each pair of horizontally
+// adjacent pixels averages to the same gray value, so every 16x16 pixel block (W and H must be
+// multiples of 16) has the same average luminance of key / inputScale
+std::shared_ptr<ImageBuffer> makeRandomImageWithScale(DeviceRef& device, int W, int H, float inputScale)
+{
+  const float value = 0.18f / inputScale;
+  Random rng;
+  auto image = std::make_shared<ImageBuffer>(device, W, H, 3);
+  for (size_t i = 0; i < image->getSize(); i += 6)
+  {
+    for (int c = 0; c < 3; ++c)
+    {
+      const float delta = (rng.getFloat() * 2.f - 1.f) * 0.9f * value;
+      image->set(i + c,     value + delta);
+      image->set(i + c + 3, value - delta);
+    }
+  }
+  return image;
+}
+
 bool isBetween(const std::shared_ptr<ImageBuffer>& image, float a, float b)
 {
   for (size_t i = 0; i < image->getSize(); ++i)
@@ -367,6 +511,114 @@ bool isBetween(const std::shared_ptr<ImageBuffer>& image, float a, float b)
   return true;
 }
 
+// Denoises an HDR color image with a new RT filter, setting the additional parameters before commit
+std::shared_ptr<ImageBuffer> filterHDRImage(DeviceRef& device, const std::shared_ptr<ImageBuffer>& color,
+                                            const std::function<void(FilterRef&)>& setParams = nullptr)
+{
+  auto output = makeImage(device, color->getW(), color->getH());
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "output", output);
+  filter.set("hdr", true);
+  if (setParams)
+    setParams(filter);
+
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  return output;
+}
+
+// Compares the HDR output of the given quality to the output of the default quality
+std::tuple<size_t, double> compareQualityOutput(DeviceRef& device, const std::shared_ptr<ImageBuffer>& color,
+                                                Quality quality, double errorThreshold)
+{
+  auto refOutput = filterHDRImage(device, color);
+  auto output = filterHDRImage(device, color, [&](FilterRef& filter)
+  {
+    filter.set("quality", quality);
+    REQUIRE(filter.get<Quality>("quality") == quality);
+  });
+
+  return compareImage(*output, *refOutput, errorThreshold);
+}
+
+// Returns the maximum absolute difference between an image and a reference image
+double getMaxAbsError(const ImageBuffer& image, const ImageBuffer& ref)
+{
+  REQUIRE(image.getDims() == ref.getDims());
+
+  double maxAbsError = 0;
+  for (size_t i = 0; i < image.getSize(); ++i)
+    maxAbsError = std::max(maxAbsError, std::abs(double(image.get(i)) - double(ref.get(i))));
+  return maxAbsError;
+}
+
+// Captures the standard output (e.g. the verbose output of the device) while in scope
+class StdoutCapture
+{
+public:
+  StdoutCapture() : prevBuf(std::cout.rdbuf(stream.rdbuf())) {}
+  ~StdoutCapture() { std::cout.rdbuf(prevBuf); }
+
+  std::string get() const { return stream.str(); }
+
+private:
+  std::stringstream stream;
+  std::streambuf* prevBuf;
+};
+
+size_t countOccurrences(const std::string& str, const std::string& substr)
+{
+  size_t count = 0;
+  for (size_t pos = str.find(substr); pos != std::string::npos; pos = str.find(substr, pos + 1))
+    ++count;
+  return count;
+}
+
+// Returns the first line of the log starting with the prefix (without the prefix), or an empty string
+std::string findLogLine(const std::string& log, const std::string& prefix)
+{
+  const size_t pos = log.find(prefix);
+  if (pos == std::string::npos)
+    return "";
+  const size_t end = log.find('\n', pos);
+  return log.substr(pos + prefix.size(), end == std::string::npos ? std::string::npos : end - pos - prefix.size());
+}
+
+// Returns the paths of the files in the directory whose names start with the prefix
+std::vector<std::string> findFiles(const std::string& dir, const std::string& prefix)
+{
+  std::vector<std::string> filenames;
+#if defined(_WIN32)
+  WIN32_FIND_DATAA data;
+  HANDLE handle = FindFirstFileA((dir + "/" + prefix + "*").c_str(), &data);
+  if (handle != INVALID_HANDLE_VALUE)
+  {
+    do
+      filenames.push_back(dir + "/" + data.cFileName);
+    while (FindNextFileA(handle, &data));
+    FindClose(handle);
+  }
+#else
+  if (DIR* dirHandle = opendir(dir.c_str()))
+  {
+    while (dirent* entry = readdir(dirHandle))
+    {
+      if (std::strncmp(entry->d_name, prefix.c_str(), prefix.size()) == 0)
+        filenames.push_back(dir + "/" + entry->d_name);
+    }
+    closedir(dirHandle);
+  }
+#endif
+  return filenames;
+}
+
 // -------------------------------------------------------------------------------------------------
 
 TEST_CASE("single filter", "[single_filter][minimal]")
@@ -655,157 +907,1082 @@ TEST_CASE("multiple devices", "[multi_device][minimal]")
 
 // -------------------------------------------------------------------------------------------------
 
-TEST_CASE("shared image", "[shared_image]")
+void cpuDeviceParamTest(const char* paramName, int paramValue)
 {
-  const int W = 198;
-  const int H = 300;
+  const int W = 1024;
+  const int H = 577;
 
-  DeviceRef device = makeAndCommitDevice();
+  DeviceRef device = makeDevice();
+  if (device.get<DeviceType>("type") != DeviceType::CPU)
+    return;
 
-  SECTION("buffer allocator")
-  {
-    // Not supported on Metal
-    if (device.get<DeviceType>("type") != DeviceType::Metal)
-    {
-      FilterRef filter = device.newFilter("RT");
-      REQUIRE(bool(filter));
+  device.set(paramName, paramValue);
+  device.commit();
+  REQUIRE(device.getError() == Error::None);
 
-      auto color  = makeConstImage(device, W, H);
-      auto output = makeImage(device, W, H);
-      setFilterImage(filter, "color",  color,  false);
-      setFilterImage(filter, "output", output, false);
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
 
-      filter.commit();
-      REQUIRE(device.getError() == Error::None);
+  auto input  = makeConstImage(device, W, H, 3, DataType::Float16, 0.5f);
+  auto output = makeConstImage(device, W, H, 3, DataType::Float16, 0.f);
+  setFilterImage(filter, "color",  input);
+  setFilterImage(filter, "output", output);
 
-      filter.execute();
-      REQUIRE(device.getError() == Error::None);
-    }
-  }
+  filter.set("hdr", true);
+  filter.set("maxMemoryMB", 200); // force tiling
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
 
-  SECTION("system allocator")
+  for (int i = 0; i < 2; ++i)
   {
-    FilterRef filter = device.newFilter("RT");
-    REQUIRE(bool(filter));
-
-    const bool systemMemorySupported = device.get<bool>("systemMemorySupported");
+    filter.execute();
     REQUIRE(device.getError() == Error::None);
+    REQUIRE(isBetween(output, 0.1f, 1.0f)); // output sanity check
+  }
+}
 
-    std::vector<int16_t> color (W * H * 3, 0);
-    std::vector<int16_t> output(W * H * 3);
+void cpuHalfPrecisionTest()
+{
+  const int W = 317;
+  const int H = 211;
 
-    filter.setImage("color",  color.data(),  Format::Half3, W, H);
-    filter.setImage("output", output.data(), Format::Half3, W, H);
+  DeviceRef refDevice = makeDevice();
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return;
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
 
-    if (systemMemorySupported)
-    {
-      REQUIRE(device.getError() == Error::None);
-      filter.commit();
-      REQUIRE(device.getError() == Error::None);
-      filter.execute();
-      REQUIRE(device.getError() == Error::None);
-    }
-    else
+  DeviceRef device = makeDevice();
+  device.set("halfPrecision", true);
+  device.commit();
+  REQUIRE(device.getError() == Error::None);
+  if (!device.get<bool>("halfPrecision"))
+    return; // not supported by the CPU backend
+
+  // The random images are the same on both devices
+  auto refOutput = filterHDRImage(refDevice, makeRandomImage(refDevice, W, H, 3, DataType::Float32, 0.f, 10.f));
+  auto output    = filterHDRImage(device,    makeRandomImage(device,    W, H, 3, DataType::Float32, 0.f, 10.f));
+
+  size_t numErrors;
+  double avgError;
+  std::tie(numErrors, avgError) = compareImage(*output, *refOutput, 0.005);
+  REQUIRE(numErrors == 0);
+}
+
+TEST_CASE("CPU device parameters", "[cpu_device_params]")
+{
+  SECTION("2 subdevices")
+  {
+    cpuDeviceParamTest("numSubdevices", 2);
+  }
+
+  SECTION("half precision")
+  {
+    cpuDeviceParamTest("halfPrecision", 1);
+    cpuHalfPrecisionTest();
+  }
+
+  SECTION("NUMA")
+  {
+    cpuDeviceParamTest("numa", 1);
+  }
+
+  SECTION("null task arena")
+  {
+    if (isCPUDeviceSupported())
     {
-      REQUIRE(device.getError() == Error::InvalidArgument);
+      DeviceRef device = newCPUDevice(nullptr);
+      REQUIRE(!device);
+      REQUIRE(getError() == Error::InvalidArgument);
     }
   }
 }
 
-// -------------------------------------------------------------------------------------------------
-
-TEST_CASE("inplace filter", "[inplace_filter]")
+TEST_CASE("weight cache", "[weight_cache]")
 {
-  // Metal requires shared buffer size to be multiple of 16K
-  const int W = 1920;
-  const int H = 1080;
+  const int W = 317;
+  const int H = 211;
+  const std::string cacheDir = ".";
+  const std::string cachePrefix = "oidn_weights_";
 
-  DeviceRef device = makeAndCommitDevice();
+  DeviceRef refDevice = makeDevice();
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return; // currently supported only by CPU devices
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
 
-  FilterRef filter = device.newFilter("RT");
-  REQUIRE(bool(filter));
+  auto refOutput = filterHDRImage(refDevice, makeRandomImage(refDevice, W, H, 3, DataType::Float32, 0.f, 10.f));
 
-  auto refColor  = makeRandomImage(device, W, H);
-  auto refOutput = makeImage(device, W, H);
+  // Start without cache files, so the first device has to save the reordered weights
+  for (const auto& filename : findFiles(cacheDir, cachePrefix))
+    std::remove(filename.c_str());
 
-  setFilterImage(filter, "color",  refColor);
-  setFilterImage(filter, "output", refOutput);
+  // The first new device saves the reordered weights and the second one maps them from the file
+  std::shared_ptr<ImageBuffer> output;
+  for (int i = 0; i < 2; ++i)
+  {
+    DeviceRef device = makeDevice();
+    device.set("weightCacheDir", cacheDir);
+    REQUIRE(device.get<std::string>("weightCacheDir") == cacheDir);
+    device.commit();
+    REQUIRE(device.getError() == Error::None);
 
-  filter.set("hdr", true);
-  filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+    bool cachedWeights = false;
+    output = filterHDRImage(device, makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 10.f),
+                            [&](FilterRef& filter)
+                            {
+                              filter.commit();
+                              cachedWeights = filter.get<bool>("cachedWeights");
+                            });
+    REQUIRE(cachedWeights == (i > 0));
+    REQUIRE(findFiles(cacheDir, cachePrefix).size() == 1);
+  }
 
-  filter.commit();
-  REQUIRE(device.getError() == Error::None);
+  for (const auto& filename : findFiles(cacheDir, cachePrefix))
+    std::remove(filename.c_str());
 
-  filter.execute();
-  REQUIRE(device.getError() == Error::None);
+  // The output with the cached weights should be the same
+  REQUIRE(compareImage(*output, *refOutput));
+}
 
-  SECTION("same buffer")
+TEST_CASE("fused processing", "[fused_process]")
+{
+  const int W = 317;
+  const int H = 211;
+
+  // The input and output processing fused into the first and last convolutions should produce the
+  // same output as the separate operations, for HDR and LDR, float and half images, with and
+  // without auxiliary images, and also with multiple tiles, whose output is cropped
+  REQUIRE(setEnvVar("OIDN_FUSE_PROCESS", 0, true));
+  DeviceRef refDevice = makeDevice();
+  setEnvVar("OIDN_FUSE_PROCESS", 1, true);
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return; // the fusion can be disabled only for CPU devices
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto filterImage = [&](DeviceRef& filterDevice, bool hdr, DataType dataType, bool aux, int maxMemoryMB)
   {
-    auto color = refColor->clone();
-    setFilterImage(filter, "color", color);
-    setFilterImage(filter, "output", color);
+    auto color  = makeRandomImage(filterDevice, W, H, 3, dataType, 0.f, hdr ? 10.f : 1.f);
+    auto output = makeImage(filterDevice, W, H, 3, dataType);
 
+    FilterRef filter = filterDevice.newFilter("RT");
+    REQUIRE(bool(filter));
+    setFilterImage(filter, "color",  color);
+    setFilterImage(filter, "output", output);
+    if (aux)
+    {
+      setFilterImage(filter, "albedo", makeRandomImage(filterDevice, W, H, 3, dataType, 0.f, 1.f));
+      setFilterImage(filter, "normal", makeRandomImage(filterDevice, W, H, 3, dataType, -1.f, 1.f));
+    }
+    filter.set("hdr", hdr);
+    if (maxMemoryMB >= 0)
+      filter.set("maxMemoryMB", maxMemoryMB);
     filter.commit();
-    REQUIRE(device.getError() == Error::None);
+    REQUIRE(filterDevice.getError() == Error::None);
 
     filter.execute();
-    REQUIRE(device.getError() == Error::None);
+    REQUIRE(filterDevice.getError() == Error::None);
+    return output;
+  };
 
-    REQUIRE(compareImage(*color, *refOutput));
+  for (bool hdr : {true, false})
+  {
+    for (DataType dataType : {DataType::Float32, DataType::Float16})
+    {
+      for (bool aux : {false, true})
+      {
+        for (int maxMemoryMB : {-1, 0})
+        {
+          auto refOutput = filterImage(refDevice, hdr, dataType, aux, maxMemoryMB);
+          auto output    = filterImage(device,    hdr, dataType, aux, maxMemoryMB);
+
+          // The fused kernels perform the same arithmetic, so only the rounding may differ
+          REQUIRE(getMaxAbsError(*output, *refOutput) < (dataType == DataType::Float16 ? 1e-2 : 1e-4));
+        }
+      }
+    }
   }
 
-  SECTION("aliased shared buffers")
+  // The fused output processing writes only the rows and columns of the tiles inside the region of
+  // interest, also for the partial tiles at the right and bottom borders of an image which is split
+  // into multiple tiles (its odd size is not a multiple of the tile size)
+  auto filterRegion = [&](DeviceRef& filterDevice, DataType dataType)
   {
-    auto color = refColor->clone();
-    BufferRef colorBuffer  = color->getBuffer();
-    BufferRef outputBuffer = device.newBuffer(colorBuffer.getData(), colorBuffer.getSize());
-
-    filter.setImage("color",  colorBuffer,  color->getFormat(), W, H);
-    filter.setImage("output", outputBuffer, color->getFormat(), W, H);
+    const int W2 = 1117;
+    const int H2 = 743;
+    const float sentinel = -1.f;
+    auto color  = makeRandomImage(filterDevice, W2, H2, 3, dataType, 0.f, 10.f);
+    auto output = makeConstImage(filterDevice, W2, H2, 3, dataType, sentinel);
 
+    FilterRef filter = filterDevice.newFilter("RT");
+    REQUIRE(bool(filter));
+    setFilterImage(filter, "color",  color);
+    setFilterImage(filter, "output", output);
+    filter.set("hdr", true);
+    filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+    filter.set("roiX", 311);
+    filter.set("roiY", 157);
+    filter.set("roiWidth", W2 - 311);  // extends to the partial tiles at the right border
+    filter.set("roiHeight", H2 - 157); // and at the bottom border
     filter.commit();
-    REQUIRE(device.getError() == Error::None);
+    REQUIRE(filterDevice.getError() == Error::None);
+    REQUIRE((filter.get<int>("tileWidth") < W2 || filter.get<int>("tileHeight") < H2));
 
     filter.execute();
-    REQUIRE(device.getError() == Error::None);
+    REQUIRE(filterDevice.getError() == Error::None);
+    REQUIRE(output->get(0) == sentinel); // outside the region
+    return output;
+  };
 
-    REQUIRE(compareImage(*color, *refOutput));
+  for (DataType dataType : {DataType::Float32, DataType::Float16})
+  {
+    auto refOutput = filterRegion(refDevice, dataType);
+    auto output    = filterRegion(device,    dataType);
+    REQUIRE(getMaxAbsError(*output, *refOutput) < (dataType == DataType::Float16 ? 1e-2 : 1e-4));
   }
 }
 
-// -------------------------------------------------------------------------------------------------
-
-TEST_CASE("filter update", "[filter_update]")
+TEST_CASE("specialized processing", "[specialized_process]")
 {
-  const int W = 211;
-  const int H = 599;
+  const int W = 317;
+  const int H = 211;
+
+  // The input and output processing kernels specialized for the image format and transfer function
+  // should produce the same output as the generic kernels, for float and half images with 1-3
+  // channels, and for all transfer functions: PU (HDR), sRGB (LDR), linear (sRGB LDR and normal)
+  // and log (lightmap)
+  REQUIRE(setEnvVar("OIDN_GENERIC_PROCESS", 1, true));
+  DeviceRef refDevice = makeDevice();
+  setEnvVar("OIDN_GENERIC_PROCESS", 0, true);
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return; // the specialization can be disabled only for CPU devices
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
 
   DeviceRef device = makeAndCommitDevice();
 
-  FilterRef filter = device.newFilter("RT");
-  REQUIRE(bool(filter));
-
-  filter.set("quality", Quality::High);
+  enum class Input { HDR, LDR, SRGB, Normal, Lightmap };
 
-  auto color  = makeConstImage(device, W, H);
-  auto albedo = makeConstImage(device, W, H);
-  auto output = makeConstImage(device, W, H);
-  setFilterImage(filter, "color",  color);
-  setFilterImage(filter, "albedo", albedo);
-  setFilterImage(filter, "output", output);
+  auto filterImage = [&](DeviceRef& filterDevice, Input input, int C, DataType dataType)
+  {
+    const float minValue = input == Input::Normal ? -1.f : 0.f;
+    const float maxValue = (input == Input::HDR || input == Input::Lightmap) ? 10.f : 1.f;
+    auto color  = makeRandomImage(filterDevice, W, H, C, dataType, minValue, maxValue);
+    auto output = makeImage(filterDevice, W, H, C, dataType);
 
-  filter.set("hdr", true);
+    FilterRef filter = filterDevice.newFilter(input == Input::Lightmap ? "RTLightmap" : "RT");
+    REQUIRE(bool(filter));
+    setFilterImage(filter, input == Input::Normal ? "normal" : "color", color);
+    setFilterImage(filter, "output", output);
+    if (input == Input::HDR)
+      filter.set("hdr", true);
+    else if (input == Input::SRGB)
+      filter.set("srgb", true);
+    filter.commit();
+    REQUIRE(filterDevice.getError() == Error::None);
 
-  filter.commit();
-  REQUIRE(device.getError() == Error::None);
+    filter.execute();
+    REQUIRE(filterDevice.getError() == Error::None);
+    return output;
+  };
 
-  filter.execute();
-  REQUIRE(device.getError() == Error::None);
+  std::vector<Input> inputs = {Input::HDR, Input::LDR, Input::SRGB, Input::Normal};
+#if defined(OIDN_FILTER_RTLIGHTMAP)
+  inputs.push_back(Input::Lightmap);
+#endif
 
-  SECTION("no updates")
+  for (Input input : inputs)
   {
-    // No changes
+    for (DataType dataType : {DataType::Float32, DataType::Float16})
+    {
+      for (int C = 1; C <= 3; ++C)
+      {
+        auto refOutput = filterImage(refDevice, input, C, dataType);
+        auto output    = filterImage(device,    input, C, dataType);
+
+        REQUIRE(getMaxAbsError(*output, *refOutput) < (dataType == DataType::Float16 ? 1e-2 : 1e-4));
+      }
+    }
+  }
+}
+
+TEST_CASE("fused pooling and upsampling", "[fuse_post_ops]")
+{
+  const int W = 317;
+  const int H = 211;
+
+  // Pooling and upsampling fused into the preceding convolutions should produce the same output as
+  // the separate operations, with both single and half precision tensors
+  for (bool halfPrecision : {false, true})
+  {
+    REQUIRE(setEnvVar("OIDN_FUSE_POST_OPS", 0, true));
+    DeviceRef refDevice = makeDevice();
+    setEnvVar("OIDN_FUSE_POST_OPS", 1, true);
+    if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+      return; // the fusion can be disabled only for CPU devices
+    refDevice.set("halfPrecision", halfPrecision);
+    refDevice.commit();
+    REQUIRE(refDevice.getError() == Error::None);
+
+    DeviceRef device = makeDevice();
+    device.set("halfPrecision", halfPrecision);
+    device.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    auto refOutput = filterHDRImage(refDevice, makeRandomImage(refDevice, W, H, 3, DataType::Float32, 0.f, 10.f));
+    auto output    = filterHDRImage(device,    makeRandomImage(device,    W, H, 3, DataType::Float32, 0.f, 10.f));
+
+    REQUIRE(getMaxAbsError(*output, *refOutput) < (halfPrecision ? 1e-2 : 1e-4));
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("tile pipelining", "[pipeline]")
+{
+  // Consecutive tiles executed concurrently by two model instances should produce the same output
+  // as executing the tiles one after the other
+  REQUIRE(setEnvVar("OIDN_PIPELINE_TILES", 0, true));
+  DeviceRef refDevice = makeDevice();
+  setEnvVar("OIDN_PIPELINE_TILES", 1, true);
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return; // the tiles are pipelined only by CPU devices
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
+
+  DeviceRef device = makeAndCommitDevice();
+
+  std::function<std::shared_ptr<ImageBuffer>(DeviceRef&)> makeColor;
+  int batchSize = 1;
+  int maxTileW = std::numeric_limits<int>::max();
+
+  SECTION("multiple tiles")
+  {
+    // Larger than the default maximum tile size, so the image is split into multiple tiles
+    const int W = 2304;
+    const int H = 2048;
+    maxTileW = W - 1;
+    makeColor = [=](DeviceRef& filterDevice)
+    {
+      return makeRandomImage(filterDevice, W, H, 3, DataType::Float32, 0.f, 10.f);
+    };
+  }
+
+  SECTION("batch")
+  {
+    // The tiles of consecutive images in the batch are pipelined too, so each image must be
+    // denoised with its own autoexposure
+    batchSize = 4;
+    makeColor = [=](DeviceRef& filterDevice)
+    {
+      const int W = 320;
+      const int H = 208;
+      auto color = makeImage(filterDevice, W, H * batchSize);
+      for (int b = 0; b < batchSize; ++b)
+      {
+        auto colorB = makeRandomImageWithScale(filterDevice, W, H, float(1 << (2*b)));
+        for (size_t i = 0; i < colorB->getSize(); ++i)
+          color->set(b * colorB->getSize() + i, colorB->get(i));
+      }
+      return color;
+    };
+  }
+
+  // Returns whether the filter is pipelined and its tile width
+  auto filterImage = [&](DeviceRef& filterDevice, bool& pipelined, int& tileW)
+  {
+    auto color = makeColor(filterDevice);
+    return filterHDRImage(filterDevice, color, [&](FilterRef& filter)
+    {
+      filter.set("batchSize", batchSize);
+      filter.commit();
+      pipelined = filter.get<bool>("pipelined");
+      tileW = filter.get<int>("tileWidth");
+    });
+  };
+
+  bool refPipelined, pipelined;
+  int refTileW, tileW;
+  auto refOutput = filterImage(refDevice, refPipelined, refTileW);
+  auto output    = filterImage(device, pipelined, tileW);
+
+  REQUIRE(pipelined);
+  REQUIRE(!refPipelined);
+  REQUIRE(tileW == refTileW);
+  REQUIRE(tileW <= maxTileW);
+
+  size_t numErrors;
+  double avgError;
+  std::tie(numErrors, avgError) = compareImage(*output, *refOutput, 1e-5);
+  REQUIRE(numErrors == 0);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("concurrent filter execution", "[concurrent]")
+{
+  const int W = 317;
+  const int H = 259;
+  const int numFilters = 3;
+
+  DeviceRef device = makeDevice();
+  if (device.get<DeviceType>("type") == DeviceType::CPU)
+    device.set("numStreams", numFilters);
+  device.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  std::vector<FilterRef> filters;
+  std::vector<std::shared_ptr<ImageBuffer>> outputs;
+
+  for (int i = 0; i < numFilters; ++i)
+  {
+    FilterRef filter = device.newFilter("RT");
+    REQUIRE(bool(filter));
+
+    auto input  = makeConstImage(device, W, H, 3, DataType::Float32, 0.2f * (i+1));
+    auto output = makeConstImage(device, W, H, 3, DataType::Float32, 0.f);
+    setFilterImage(filter, "color",  input);
+    setFilterImage(filter, "output", output);
+    filter.set("hdr", true);
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filters.push_back(filter);
+    outputs.push_back(output);
+  }
+
+  // Execute the filters simultaneously from multiple threads (errors are per thread)
+  for (int k = 0; k < 2; ++k)
+  {
+    std::vector<Error> errors(numFilters, Error::Unknown);
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < numFilters; ++i)
+    {
+      threads.emplace_back([&, i]()
+      {
+        filters[i].executeAsync();
+        errors[i] = device.getError();
+      });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    device.sync();
+    REQUIRE(device.getError() == Error::None);
+
+    for (int i = 0; i < numFilters; ++i)
+    {
+      REQUIRE(errors[i] == Error::None);
+      REQUIRE(isBetween(outputs[i], 0.1f, 1.0f)); // output sanity check
+    }
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("shared image", "[shared_image]")
+{
+  const int W = 198;
+  const int H = 300;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  SECTION("buffer allocator")
+  {
+    // Not supported on Metal
+    if (device.get<DeviceType>("type") != DeviceType::Metal)
+    {
+      FilterRef filter = device.newFilter("RT");
+      REQUIRE(bool(filter));
+
+      auto color  = makeConstImage(device, W, H);
+      auto output = makeImage(device, W, H);
+      setFilterImage(filter, "color",  color,  false);
+      setFilterImage(filter, "output", output, false);
+
+      filter.commit();
+      REQUIRE(device.getError() == Error::None);
+
+      filter.execute();
+      REQUIRE(device.getError() == Error::None);
+    }
+  }
+
+  SECTION("system allocator")
+  {
+    FilterRef filter = device.newFilter("RT");
+    REQUIRE(bool(filter));
+
+    const bool systemMemorySupported = device.get<bool>("systemMemorySupported");
+    REQUIRE(device.getError() == Error::None);
+
+    std::vector<int16_t> color (W * H * 3, 0);
+    std::vector<int16_t> output(W * H * 3);
+
+    filter.setImage("color",  color.data(),  Format::Half3, W, H);
+    filter.setImage("output", output.data(), Format::Half3, W, H);
+
+    if (systemMemorySupported)
+    {
+      REQUIRE(device.getError() == Error::None);
+      filter.commit();
+      REQUIRE(device.getError() == Error::None);
+      filter.execute();
+      REQUIRE(device.getError() == Error::None);
+    }
+    else
+    {
+      REQUIRE(device.getError() == Error::InvalidArgument);
+    }
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("inplace filter", "[inplace_filter]")
+{
+  // Metal requires shared buffer size to be multiple of 16K
+  const int W = 1920;
+  const int H = 1080;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+
+  auto refColor  = makeRandomImage(device, W, H);
+  auto refOutput = makeImage(device, W, H);
+
+  setFilterImage(filter, "color",  refColor);
+  setFilterImage(filter, "output", refOutput);
+
+  filter.set("hdr", true);
+  filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  SECTION("same buffer")
+  {
+    auto color = refColor->clone();
+    setFilterImage(filter, "color", color);
+    setFilterImage(filter, "output", color);
+
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+
+    REQUIRE(compareImage(*color, *refOutput));
+  }
+
+  SECTION("aliased shared buffers")
+  {
+    auto color = refColor->clone();
+    BufferRef colorBuffer  = color->getBuffer();
+    BufferRef outputBuffer = device.newBuffer(colorBuffer.getData(), colorBuffer.getSize());
+
+    filter.setImage("color",  colorBuffer,  color->getFormat(), W, H);
+    filter.setImage("output", outputBuffer, color->getFormat(), W, H);
+
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+
+    REQUIRE(compareImage(*color, *refOutput));
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("batched filter", "[batch_filter]")
+{
+  const int W = 257;
+  const int H = 129;
+  const int batchSize = 3;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  // Denoise all images with a single batched execution
+  auto batchColor  = makeRandomImage(device, W, H * batchSize, 3, DataType::Float32, 0.f, 10.f);
+  auto batchOutput = makeImage(device, W, H * batchSize);
+
+  FilterRef batchFilter = device.newFilter("RT");
+  REQUIRE(bool(batchFilter));
+  setFilterImage(batchFilter, "color",  batchColor);
+  setFilterImage(batchFilter, "output", batchOutput);
+  batchFilter.set("hdr", true);
+  batchFilter.set("batchSize", batchSize);
+
+  batchFilter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  batchFilter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Denoise the images one by one and compare
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  filter.set("hdr", true);
+
+  const size_t numValues = size_t(W) * H * 3;
+  for (int b = 0; b < batchSize; ++b)
+  {
+    auto color  = makeImage(device, W, H);
+    auto output = makeImage(device, W, H);
+    for (size_t i = 0; i < numValues; ++i)
+      color->set(i, batchColor->get(b * numValues + i));
+
+    setFilterImage(filter, "color",  color);
+    setFilterImage(filter, "output", output);
+
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+
+    bool equal = true;
+    for (size_t i = 0; i < numValues; ++i)
+      equal = equal && (output->get(i) == batchOutput->get(b * numValues + i));
+    REQUIRE(equal);
+  }
+
+  SECTION("invalid batch size")
+  {
+    batchFilter.set("batchSize", 2); // image height is not a multiple of the batch size
+    batchFilter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("prefiltered auxiliary images", "[prefilter_aux]")
+{
+  const int W = 317;
+  const int H = 241;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto color  = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 1.f);
+  auto albedo = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 1.f);
+  auto normal = makeRandomImage(device, W, H, 3, DataType::Float32, -1.f, 1.f);
+
+  // Prefilter the auxiliary images with separate filters and denoise with clean auxiliary images
+  auto albedoClean = makeImage(device, W, H);
+  auto normalClean = makeImage(device, W, H);
+  auto refOutput   = makeImage(device, W, H);
+
+  FilterRef albedoFilter = device.newFilter("RT");
+  setFilterImage(albedoFilter, "albedo", albedo);
+  setFilterImage(albedoFilter, "output", albedoClean);
+  albedoFilter.commit();
+  albedoFilter.execute();
+
+  FilterRef normalFilter = device.newFilter("RT");
+  setFilterImage(normalFilter, "normal", normal);
+  setFilterImage(normalFilter, "output", normalClean);
+  normalFilter.commit();
+  normalFilter.execute();
+
+  FilterRef refFilter = device.newFilter("RT");
+  setFilterImage(refFilter, "color",  color);
+  setFilterImage(refFilter, "albedo", albedoClean);
+  setFilterImage(refFilter, "normal", normalClean);
+  setFilterImage(refFilter, "output", refOutput);
+  refFilter.set("cleanAux", true);
+  refFilter.commit();
+  refFilter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Prefilter the auxiliary images in the same filter
+  auto output = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "albedo", albedo);
+  setFilterImage(filter, "normal", normal);
+  setFilterImage(filter, "output", output);
+  filter.set("prefilterAux", true);
+  REQUIRE(filter.get<bool>("prefilterAux"));
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  SECTION("single tile")
+  {
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+
+    bool close = true;
+    for (size_t i = 0; i < output->getSize(); ++i)
+      close = close && std::abs(output->get(i) - refOutput->get(i)) <= 1e-3f;
+    REQUIRE(close);
+  }
+
+  SECTION("multiple tiles")
+  {
+    filter.set("maxMemoryMB", 0); // force tiling
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(isBetween(output, 0.f, 1.f)); // output sanity check
+  }
+
+  SECTION("missing auxiliary image")
+  {
+    filter.unsetImage("normal");
+    filter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+  }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("region of interest", "[roi]")
+{
+  const int W = 1117;
+  const int H = 743;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto color     = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 1.f);
+  auto refOutput = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "output", refOutput);
+  filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // The pixels outside the rectangles should keep the sentinel value
+  const float sentinel = -1.f;
+  auto output = makeConstImage(device, W, H, 3, DataType::Float32, sentinel);
+  setFilterImage(filter, "output", output);
+
+  // Only the pixels inside the rectangles should be changed, which are compared to the full output
+  auto checkImage = [&](const ImageBuffer& result, const ImageBuffer& outside,
+                        const std::vector<std::array<int, 4>>& rects)
+  {
+    bool valid = true;
+    for (int h = 0; h < H; ++h)
+    {
+      for (int w = 0; w < W; ++w)
+      {
+        bool inside = false;
+        for (const auto& rect : rects)
+          inside = inside || (w >= rect[0] && w < rect[0] + rect[2] && h >= rect[1] && h < rect[1] + rect[3]);
+
+        for (int c = 0; c < 3; ++c)
+        {
+          const size_t i = (size_t(h) * W + w) * 3 + c;
+          if (inside)
+            valid = valid && std::abs(result.get(i) - refOutput->get(i)) <= 1e-3f;
+          else
+            valid = valid && result.get(i) == outside.get(i);
+        }
+      }
+    }
+    return valid;
+  };
+
+  auto checkOutput = [&](const std::vector<std::array<int, 4>>& rects)
+  {
+    return checkImage(*output, *makeConstImage(device, W, H, 3, DataType::Float32, sentinel), rects);
+  };
+
+  SECTION("single region")
+  {
+    filter.set("roiX", 311);
+    filter.set("roiY", 157);
+    filter.set("roiWidth", 403);
+    filter.set("roiHeight", 229);
+    REQUIRE(filter.get<int>("roiWidth") == 403);
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkOutput({{311, 157, 403, 229}}));
+  }
+
+  SECTION("dirty rectangles")
+  {
+    int rects[] = {0, 0, 64, 32,
+                   1000, 700, 500, 500, // clipped to the image
+                   517, 0, 23, 743};
+    filter.setData("dirtyRects", rects, sizeof(rects));
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkOutput({{0, 0, 64, 32}, {1000, 700, 117, 43}, {517, 0, 23, 743}}));
+  }
+
+  SECTION("in-place dirty rectangles")
+  {
+    // Adjacent and overlapping rectangles of a single-tile in-place filter must not read the
+    // pixels already denoised by the other rectangles
+    auto image = color->clone();
+    FilterRef inplaceFilter = device.newFilter("RT");
+    REQUIRE(bool(inplaceFilter));
+    setFilterImage(inplaceFilter, "color",  image);
+    setFilterImage(inplaceFilter, "output", image);
+    int rects[] = {311, 157, 200, 229,
+                   511, 157, 200, 229,
+                   450, 300, 100, 100};
+    inplaceFilter.setData("dirtyRects", rects, sizeof(rects));
+    inplaceFilter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    inplaceFilter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkImage(*image, *color, {{311, 157, 400, 229}, {450, 300, 100, 100}}));
+  }
+
+  SECTION("invalid region size")
+  {
+    filter.set("roiWidth", -1);
+    REQUIRE(device.getError() == Error::InvalidArgument);
+  }
+}
+
+#if defined(OIDN_FILTER_RTLIGHTMAP)
+
+TEST_CASE("lightmap coverage", "[lightmap_coverage]")
+{
+  const int W = 2011;
+  const int H = 257;
+  const int coveredW = 411; // only the left part of the atlas is used
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto color    = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 1.f);
+  auto coverage = makeImage(device, W, H, 1);
+  for (int h = 0; h < H; ++h)
+    for (int w = 0; w < W; ++w)
+      coverage->set(size_t(h) * W + w, w < coveredW ? 1.f : 0.f);
+
+  auto refOutput = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RTLightmap");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "output", refOutput);
+  filter.set("inputScale", 1.f);
+  filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // The covered texels should be the same, and the empty tiles should not be written
+  const float sentinel = -1.f;
+  auto output = makeConstImage(device, W, H, 3, DataType::Float32, sentinel);
+  setFilterImage(filter, "output",   output);
+  setFilterImage(filter, "coverage", coverage);
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  bool equal = true;
+  for (int h = 0; h < H; ++h)
+    for (int w = 0; w < coveredW; ++w)
+      for (int c = 0; c < 3; ++c)
+        equal = equal && output->get((size_t(h) * W + w) * 3 + c) == refOutput->get((size_t(h) * W + w) * 3 + c);
+  REQUIRE(equal);
+  REQUIRE(output->get(size_t(W) * H * 3 - 1) == sentinel);
+
+  SECTION("updated coverage")
+  {
+    // The updated contents should be read only after setting the coverage image again
+    for (size_t i = 0; i < coverage->getSize(); ++i)
+      coverage->set(i, 1.f);
+
+    auto output2 = makeConstImage(device, W, H, 3, DataType::Float32, sentinel);
+    setFilterImage(filter, "output", output2);
+    filter.commit();
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(output2->get(size_t(W) * H * 3 - 1) == sentinel);
+
+    setFilterImage(filter, "coverage", coverage);
+    filter.commit();
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(compareImage(*output2, *refOutput));
+  }
+
+  SECTION("coverage size mismatch")
+  {
+    setFilterImage(filter, "coverage", makeImage(device, W, H - 1, 1));
+    filter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+  }
+}
+
+#endif // defined(OIDN_FILTER_RTLIGHTMAP)
+
+// -------------------------------------------------------------------------------------------------
+
+// Streams the rows of an image from/to host memory, counting the streamed rows
+struct ImageStreamState
+{
+  std::vector<float> data;
+  int W;
+  size_t numRows = 0;
+};
+
+bool inputStreamCallback(void* userPtr, size_t y, size_t numRows, void* data, size_t rowByteStride)
+{
+  auto& state = *static_cast<ImageStreamState*>(userPtr);
+  for (size_t i = 0; i < numRows; ++i)
+    std::memcpy(static_cast<char*>(data) + i * rowByteStride, &state.data[(y + i) * state.W * 3],
+                state.W * 3 * sizeof(float));
+  state.numRows += numRows;
+  return true;
+}
+
+bool outputStreamCallback(void* userPtr, size_t y, size_t numRows, void* data, size_t rowByteStride)
+{
+  auto& state = *static_cast<ImageStreamState*>(userPtr);
+  for (size_t i = 0; i < numRows; ++i)
+    std::memcpy(&state.data[(y + i) * state.W * 3], static_cast<char*>(data) + i * rowByteStride,
+                state.W * 3 * sizeof(float));
+  state.numRows += numRows;
+  return true;
+}
+
+TEST_CASE("streamed filter", "[stream_filter]")
+{
+  const int W = 317;
+  const int H = 2011; // multiple bands
+
+  DeviceRef device = makeAndCommitDevice();
+
+  // Denoise the image stored in memory
+  auto color  = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 1.f);
+  auto output = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "output", output);
+  filter.set("maxMemoryMB", 0); // use the same tiles as for streaming
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Denoise the same image streamed in bands
+  ImageStreamState colorStream;
+  colorStream.W = W;
+  for (size_t i = 0; i < color->getSize(); ++i)
+    colorStream.data.push_back(color->get(i));
+
+  ImageStreamState outputStream;
+  outputStream.W = W;
+  outputStream.data.resize(size_t(W) * H * 3);
+
+  FilterRef streamFilter = device.newFilter("RT");
+  REQUIRE(bool(streamFilter));
+  streamFilter.setImageStream("color",  inputStreamCallback,  &colorStream,  Format::Float3, W, H);
+  streamFilter.setImageStream("output", outputStreamCallback, &outputStream, Format::Float3, W, H);
+  streamFilter.set("maxMemoryMB", 0);
+  streamFilter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  streamFilter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Each row should be streamed exactly once
+  REQUIRE(colorStream.numRows  == size_t(H));
+  REQUIRE(outputStream.numRows == size_t(H));
+
+  bool equal = true;
+  for (size_t i = 0; i < output->getSize(); ++i)
+    equal = equal && (output->get(i) == outputStream.data[i]);
+  REQUIRE(equal);
+
+  SECTION("mixed streamed and stored images")
+  {
+    setFilterImage(streamFilter, "output", output);
+    streamFilter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+  }
+
+  SECTION("streamed HDR image without input scale")
+  {
+    // The missing input scale should be reported already by the commit
+    streamFilter.set("hdr", true);
+    streamFilter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+
+    streamFilter.set("inputScale", 1.f);
+    streamFilter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    // Resetting the input scale does not reinitialize the filter but should be checked too
+    streamFilter.set("inputScale", std::numeric_limits<float>::quiet_NaN());
+    streamFilter.commit();
+    REQUIRE(device.getError() == Error::InvalidOperation);
+  }
+}
+
+TEST_CASE("filter update", "[filter_update]")
+{
+  const int W = 211;
+  const int H = 599;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+
+  filter.set("quality", Quality::High);
+
+  auto color  = makeConstImage(device, W, H);
+  auto albedo = makeConstImage(device, W, H);
+  auto output = makeConstImage(device, W, H);
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "albedo", albedo);
+  setFilterImage(filter, "output", output);
+
+  filter.set("hdr", true);
+
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  SECTION("no updates")
+  {
+    // No changes
   }
 
   SECTION("same image size")
@@ -814,6 +1991,23 @@ TEST_CASE("filter update", "[filter_update]")
     setFilterImage(filter, "color", color);
   }
 
+  SECTION("same image size, new buffers (video frame)")
+  {
+    color  = makeConstImage(device, W, H);
+    albedo = makeConstImage(device, W, H);
+    output = makeConstImage(device, W, H);
+    setFilterImage(filter, "color",  color);
+    setFilterImage(filter, "albedo", albedo);
+    setFilterImage(filter, "output", output);
+  }
+
+  SECTION("same image size, in-place")
+  {
+    output = makeConstImage(device, W, H);
+    setFilterImage(filter, "color",  output);
+    setFilterImage(filter, "output", output);
+  }
+
   SECTION("larger image size")
   {
     color  = makeConstImage(device, W*2, H*2);
@@ -868,6 +2062,249 @@ TEST_CASE("filter update", "[filter_update]")
   REQUIRE(isBetween(output, 0.1f, 1.0f)); // output sanity check
 }
 
+TEST_CASE("frame rebinding", "[frame_rebinding]")
+{
+  const int W = 317;
+  const int H = 211;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto color  = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 10.f);
+  auto output = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+  setFilterImage(filter, "color",  color);
+  setFilterImage(filter, "output", output);
+  filter.set("hdr", true);
+  filter.set("cacheAutoexposure", true);
+  REQUIRE(filter.get<bool>("cacheAutoexposure"));
+  filter.commit();
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Rebinding new images with the same size and format should produce the same output as a new
+  // filter, so the cached autoexposure result of the previous frame must not be used
+  for (int i = 0; i < 3; ++i)
+  {
+    color  = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 10.f * (i + 2));
+    output = makeImage(device, W, H);
+    setFilterImage(filter, "color",  color);
+    setFilterImage(filter, "output", output);
+    filter.commit();
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(compareImage(*output, *filterHDRImage(device, color)));
+  }
+
+  // Reference output of a brighter frame in the same buffer
+  for (size_t i = 0; i < color->getSize(); ++i)
+    color->set(i, color->get(i) * 4.f);
+  auto refOutput = filterHDRImage(device, color);
+
+  SECTION("cached autoexposure")
+  {
+    // The cached autoexposure result of the previous contents is used if the image is not set again
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+
+    size_t numErrors;
+    double avgError;
+    std::tie(numErrors, avgError) = compareImage(*output, *refOutput, 1e-3);
+    REQUIRE(numErrors != 0);
+  }
+
+  SECTION("rebound image")
+  {
+    // Setting the image again discards the cached autoexposure result
+    setFilterImage(filter, "color", color);
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(compareImage(*output, *refOutput));
+  }
+}
+
+TEST_CASE("tile size autotuning", "[autotune]")
+{
+  const int W = 1117;
+  const int H = 743;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  auto color = makeRandomImage(device, W, H, 3, DataType::Float32, 0.f, 10.f);
+  auto refOutput = filterHDRImage(device, color);
+
+  // The first filter measures the tile sizes and the second one reuses the tuned tile size
+  std::shared_ptr<ImageBuffer> outputs[2];
+  int tileSizes[2][2];
+  for (int i = 0; i < 2; ++i)
+  {
+    outputs[i] = filterHDRImage(device, color, [&](FilterRef& filter)
+    {
+      filter.set("autotune", true);
+      REQUIRE(filter.get<bool>("autotune"));
+      filter.commit();
+      tileSizes[i][0] = filter.get<int>("tileWidth");
+      tileSizes[i][1] = filter.get<int>("tileHeight");
+    });
+  }
+
+  REQUIRE(tileSizes[0][0] > 0);
+  REQUIRE(tileSizes[0][1] > 0);
+  REQUIRE(tileSizes[1][0] == tileSizes[0][0]);
+  REQUIRE(tileSizes[1][1] == tileSizes[0][1]);
+
+  // The tile size should not change the output beyond the differences at the tile seams
+  size_t numErrors;
+  double avgError;
+  std::tie(numErrors, avgError) = compareImage(*outputs[0], *refOutput, 1e-3);
+  REQUIRE(numErrors == 0);
+  REQUIRE(compareImage(*outputs[1], *outputs[0]));
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("fast math", "[fast_math]")
+{
+  DeviceRef device = makeAndCommitDevice();
+
+  // The HDR color-only model has the same weights for high and balanced quality, but balanced may
+  // use faster, less accurate convolutions (e.g. Winograd on CPU)
+  auto color = makeRandomImage(device, 317, 211, 3, DataType::Float32, 0.f, 10.f);
+
+  size_t numErrors;
+  double avgError;
+  std::tie(numErrors, avgError) = compareQualityOutput(device, color, Quality::Balanced, 0.005);
+  REQUIRE(numErrors == 0);
+  REQUIRE(avgError < 0.001);
+}
+
+TEST_CASE("Winograd convolution", "[winograd]")
+{
+  // Winograd convolutions with both output tile sizes should produce the same output as direct
+  // convolutions with the same weights, up to small rounding differences in every pixel
+  REQUIRE(setEnvVar("OIDN_WINOGRAD", 0, true));
+  DeviceRef refDevice = makeDevice();
+  setEnvVar("OIDN_WINOGRAD", -1, true);
+  if (refDevice.get<DeviceType>("type") != DeviceType::CPU)
+    return; // the Winograd tile size can be set only for CPU devices
+  refDevice.commit();
+  REQUIRE(refDevice.getError() == Error::None);
+
+  auto setBalanced = [](FilterRef& filter) { filter.set("quality", Quality::Balanced); };
+  auto refOutput = filterHDRImage(refDevice,
+                                  makeRandomImage(refDevice, 317, 211, 3, DataType::Float32, 0.f, 10.f),
+                                  setBalanced);
+
+  for (int winogradM : {2, 4})
+  {
+    REQUIRE(setEnvVar("OIDN_WINOGRAD", winogradM, true));
+    DeviceRef device = makeAndCommitDevice();
+    setEnvVar("OIDN_WINOGRAD", -1, true);
+
+    auto output = filterHDRImage(device,
+                                 makeRandomImage(device, 317, 211, 3, DataType::Float32, 0.f, 10.f),
+                                 setBalanced);
+
+    REQUIRE(getMaxAbsError(*output, *refOutput) < (winogradM == 2 ? 1e-3 : 5e-3));
+  }
+}
+
+TEST_CASE("preview quality", "[preview_quality]")
+{
+  // Preview quality uses the same weights as fast quality but they may be quantized to int8, which
+  // should add only a small absolute error to the FP32 output of fast quality. Winograd convolutions
+  // are disabled for fast quality, so the only difference is the quantization.
+  REQUIRE(setEnvVar("OIDN_WINOGRAD", 0, true));
+  DeviceRef device = makeAndCommitDevice();
+  setEnvVar("OIDN_WINOGRAD", -1, true);
+
+  auto color = makeRandomImage(device, 317, 211, 3, DataType::Float32, 0.f, 10.f);
+
+  auto fastOutput = filterHDRImage(device, color,
+                                   [](FilterRef& filter) { filter.set("quality", Quality::Fast); });
+  auto previewOutput = filterHDRImage(device, color,
+                                      [](FilterRef& filter) { filter.set("quality", Quality::Preview); });
+
+  REQUIRE(getMaxAbsError(*previewOutput, *fastOutput) < 0.1);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST_CASE("temporal autoexposure", "[temporal_autoexposure]")
+{
+  const int W = 320;
+  const int H = 208;
+
+  DeviceRef device = makeAndCommitDevice();
+
+  // The frames have different brightness with known input scales
+  auto color1 = makeRandomImageWithScale(device, W, H, 4.f);
+  auto color2 = makeRandomImageWithScale(device, W, H, 16.f);
+  auto output = makeImage(device, W, H);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+
+  setFilterImage(filter, "color",  color1);
+  setFilterImage(filter, "output", output);
+  filter.set("hdr", true);
+
+  // Checks whether the output matches filtering the color image with the specified input scale
+  auto checkScale = [&](const std::shared_ptr<ImageBuffer>& color, float inputScale)
+  {
+    auto refOutput = filterHDRImage(device, color, [&](FilterRef& refFilter)
+    {
+      refFilter.set("inputScale", inputScale);
+    });
+
+    size_t numErrors;
+    double avgError;
+    std::tie(numErrors, avgError) = compareImage(*output, *refOutput, 1e-3);
+    return numErrors == 0;
+  };
+
+  SECTION("brightness change")
+  {
+    filter.set("temporalAutoexposure", true);
+    filter.set("autoexposureSmoothing", 0.75f);
+    REQUIRE(filter.get<bool>("temporalAutoexposure"));
+    REQUIRE(filter.get<float>("autoexposureSmoothing") == 0.75f);
+
+    filter.commit();
+    REQUIRE(device.getError() == Error::None);
+
+    // The first frame has no previous input scale, so its own is used
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkScale(color1, 4.f));
+
+    // The second frame should use the input scale of the first frame
+    setFilterImage(filter, "color", color2);
+    filter.commit();
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkScale(color2, 4.f));
+    REQUIRE(!checkScale(color2, 16.f));
+
+    // The third frame should use the input scales of the first two frames blended in the log
+    // domain: 2^(0.75 * log2(4) + 0.25 * log2(16))
+    filter.execute();
+    REQUIRE(device.getError() == Error::None);
+    REQUIRE(checkScale(color2, 4.f * std::sqrt(2.f)));
+    REQUIRE(!checkScale(color2, 4.f));
+  }
+
+  SECTION("invalid smoothing factor")
+  {
+    filter.set("autoexposureSmoothing", 1.f);
+    REQUIRE(device.getError() == Error::InvalidArgument);
+  }
+}
+
 // -------------------------------------------------------------------------------------------------
 
 TEST_CASE("async filter", "[async_filter]")
@@ -1166,6 +2603,68 @@ TEST_CASE("progress monitor", "[progress]")
 
 // -------------------------------------------------------------------------------------------------
 
+void profilingCallback(void* userPtr, const ProfileRecord* records, int numRecords)
+{
+  auto& ops = *static_cast<std::vector<std::pair<std::string, int>>*>(userPtr);
+  for (int i = 0; i < numRecords; ++i)
+  {
+    REQUIRE(records[i].time >= 0);
+    ops.emplace_back(records[i].name, records[i].count);
+  }
+}
+
+TEST_CASE("profiling", "[profiling]")
+{
+  const int W = 1283;
+  const int H = 727;
+
+  DeviceRef device = makeDevice();
+  device.set("profiling", true);
+  device.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  FilterRef filter = device.newFilter("RT");
+  REQUIRE(bool(filter));
+
+  auto image = makeConstImage(device, W, H);
+  setFilterImage(filter, "color",  image);
+  setFilterImage(filter, "output", image); // in-place
+
+  filter.set("maxMemoryMB", 0); // make sure there will be multiple tiles
+
+  std::vector<std::pair<std::string, int>> ops;
+  filter.setProfilingFunction(profilingCallback, &ops);
+
+  filter.commit();
+  REQUIRE(device.getError() == Error::None);
+
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+
+  // Every operation of the model should be executed once per tile
+  REQUIRE(!ops.empty());
+  auto inputIter = std::find_if(ops.begin(), ops.end(),
+                                [](const std::pair<std::string, int>& op) { return op.first == "input"; });
+  REQUIRE(inputIter != ops.end());
+  REQUIRE(inputIter->second > 1);
+
+  bool sameCount = true;
+  for (const auto& op : ops)
+  {
+    if (op.first.find("conv") != std::string::npos)
+      sameCount = sameCount && op.second == inputIter->second;
+  }
+  REQUIRE(sameCount);
+
+  // The records should be reported again for each execution
+  ops.clear();
+  filter.execute();
+  REQUIRE(device.getError() == Error::None);
+  REQUIRE(!ops.empty());
+}
+
+// -------------------------------------------------------------------------------------------------
+
 TEST_CASE("user weights", "[user_weights]")
 {
   DeviceRef device = makeAndCommitDevice();
@@ -10,6 +10,7 @@ OIDN_NAMESPACE_BEGIN
     switch (dataType)
     {
     case DataType::UInt8:   return 1;
+    case DataType::Int8:    return 1;
     case DataType::Float16: return sizeof(int16_t);
     case DataType::Float32: return sizeof(float);
     default:
@@ -90,6 +90,7 @@ OIDN_NAMESPACE_BEGIN
     case Quality::High:     sm << "high";     break;
     case Quality::Balanced: sm << "balanced"; break;
     case Quality::Fast:     sm << "fast";     break;
+    case Quality::Preview:  sm << "preview";  break;
     default:
       throw std::invalid_argument("invalid quality mode");
     }
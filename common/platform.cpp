@@ -49,6 +49,7 @@ OIDN_NAMESPACE_BEGIN
     {
     case DataType::Void:    sm << "v";   break;
     case DataType::UInt8:   sm << "u8";  break;
+    case DataType::Int8:    sm << "s8";  break;
     case DataType::Float16: sm << "f16"; break;
     case DataType::Float32: sm << "f32"; break;
     default:                sm << "?";   break;
@@ -242,6 +242,7 @@ OIDN_NAMESPACE_BEGIN
   {
     Void,
     UInt8,
+    Int8,
     Float16,
     Float32,
   };
@@ -49,6 +49,13 @@ OIDN_NAMESPACE_BEGIN
     dirty = true;
   }
 
+  void ArenaPlanner::setAllocByteSize(int allocID, size_t byteSize)
+  {
+    checkAllocID(allocID);
+    allocs[allocID]->byteSize = byteSize;
+    dirty = true;
+  }
+
   void ArenaPlanner::commit()
   {
     if (!dirty)
@@ -92,6 +99,20 @@ OIDN_NAMESPACE_BEGIN
       chunks.push_back(chunk);
     }
 
+    // Compute the lower bound of the total size: the peak total size of the chunks used by any op
+    std::vector<size_t> opByteSizes;
+    for (const Chunk& chunk : chunks)
+    {
+      if (chunk.lastOpID >= int(opByteSizes.size()))
+        opByteSizes.resize(chunk.lastOpID + 1, 0);
+      for (int opID = chunk.firstOpID; opID <= chunk.lastOpID; ++opID)
+        opByteSizes[opID] += chunk.byteSize;
+    }
+
+    lowerBoundByteSize = 0;
+    for (size_t opByteSize : opByteSizes)
+      lowerBoundByteSize = max(lowerBoundByteSize, opByteSize);
+
     // Sort the chunks by size in descending order
     std::sort(chunks.begin(), chunks.end(),
               [](const Chunk& a, const Chunk& b) { return a.byteSize > b.byteSize; });
@@ -156,6 +177,7 @@ OIDN_NAMESPACE_BEGIN
     allocs.clear();
     totalByteSize = 0;
     totalByteAlignment = 1;
+    lowerBoundByteSize = 0;
     dirty = false;
   }
 
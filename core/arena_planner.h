@@ -1,6 +1,8 @@
 // Copyright 2023 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 
+#pragma once
+
 #include "common/platform.h"
 #include <vector>
 
@@ -19,6 +21,9 @@ public:
   // allocations to be stored consecutively in memory
   void addDepAllocs(int opID, const std::vector<int>& allocIDs, bool concatAllocs = false);
 
+  // Changes the size of an allocation, e.g. to zero if it turns out to be unnecessary
+  void setAllocByteSize(int allocID, size_t byteSize);
+
   // Commits changes to the plan, after which it's possible to query the offsets of the allocations
   void commit();
 
@@ -39,6 +44,14 @@ public:
     return totalByteAlignment;
   }
 
+  // Returns the theoretical lower bound of the required memory size, which is the maximum total
+  // size of the allocations used at the same time (must be called after committing)
+  size_t getLowerBoundByteSize() const
+  {
+    checkCommitted();
+    return lowerBoundByteSize;
+  }
+
   // Returns the offset of the specified allocation (must be called after committing)
   size_t getAllocByteOffset(int allocID) const
   {
@@ -91,6 +104,7 @@ private:
   std::vector<std::unique_ptr<Alloc>> allocs;
   size_t totalByteSize = 0;
   size_t totalByteAlignment = 1;
+  size_t lowerBoundByteSize = 0;
   bool dirty = false;
 };
 
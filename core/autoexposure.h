@@ -41,6 +41,17 @@ OIDN_NAMESPACE_BEGIN
     void setDst(const Ref<Record<float>>& dst) { this->dst = dst; }
     float* getDstPtr() const { return dst->getPtr(); }
 
+    const char* getTypeName() const override { return "autoexposure"; }
+
+    OpCost getCost() const override
+    {
+      OpCost cost;
+      cost.bytesRead    = srcDesc.getNumElements() * getFormatSize(srcDesc.format);
+      cost.bytesWritten = sizeof(float);
+      cost.flops        = srcDesc.getNumElements() * 3; // luminance
+      return cost;
+    }
+
   protected:
     ImageDesc srcDesc;
     Ref<Image> src;
@@ -52,4 +52,15 @@ OIDN_NAMESPACE_BEGIN
     updateDst();
   }
 
+  OpCost ConcatConv::getCost() const
+  {
+    OpCost cost;
+    cost.bytesRead    = src1Desc.getByteSize() + src2Desc.getByteSize() +
+                        weightDesc.getByteSize() + biasDesc.getByteSize();
+    cost.bytesWritten = dstDesc.getByteSize();
+    cost.flops        = size_t(2) * weightDesc.getO() * weightDesc.getI() *
+                        weightDesc.getH() * weightDesc.getW() * src1Desc.getH() * src1Desc.getW();
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
@@ -15,7 +15,8 @@ OIDN_NAMESPACE_BEGIN
     TensorDesc weightDesc;
     TensorDesc biasDesc;
     Activation activation;
-    bool fastMath; // prefer performance over accuracy
+    bool fastMath;  // prefer performance over accuracy
+    bool quantized; // allow quantized (int8) weights
   };
 
   class ConcatConv : public BaseOp, protected ConcatConvDesc
@@ -30,6 +31,9 @@ OIDN_NAMESPACE_BEGIN
     void setBias(const Ref<Tensor>& bias);
     void setDst(const Ref<Tensor>& dst);
 
+    const char* getTypeName() const override { return "concat_conv"; }
+    OpCost getCost() const override;
+
   protected:
     virtual void updateSrc() {}
     virtual void updateBias() {}
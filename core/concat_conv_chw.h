@@ -19,9 +19,17 @@ OIDN_NAMESPACE_BEGIN
     size_t getScratchByteSize() override { return conv->getScratchByteSize(); }
     void setScratch(const Ref<Buffer>& scratch) override { conv->setScratch(scratch); }
 
+    TensorDesc getWeightDesc() const { return conv->getWeightDesc(); }
     void setWeight(const Ref<Tensor>& weight) { conv->setWeight(weight); }
 
-    void finalize() override { conv->finalize(); }
+    TensorDesc getWeightScaleDesc() const { return conv->getWeightScaleDesc(); }
+    void setWeightScale(const Ref<Tensor>& weightScale) { conv->setWeightScale(weightScale); }
+
+    void finalize() override
+    {
+      conv->setName(getName()); // for debugging
+      conv->finalize();
+    }
     void submitKernels(const Ref<CancellationToken>& ct) override { conv->submitKernels(ct); }
 
   private:
@@ -24,11 +24,12 @@ OIDN_NAMESPACE_BEGIN
                    weightDesc.dataType};
 
     // Convolution 1: dst = conv(src1, weight1) + bias
-    conv1 = engine->newConv({src1Desc, weight1Desc, biasDesc, Activation::None, PostOp::None, fastMath});
+    // The split weights are set directly, so they cannot be quantized
+    conv1 = engine->newConv({src1Desc, weight1Desc, biasDesc, Activation::None, PostOp::None, fastMath, false});
 
     // Convolution 2: dst = activation(conv(src2, weight2) + dst)
     // We use dst as bias
-    conv2 = engine->newConv({src2Desc, weight2Desc, dstDesc, activation, PostOp::None, fastMath});
+    conv2 = engine->newConv({src2Desc, weight2Desc, dstDesc, activation, PostOp::None, fastMath, false});
   }
 
   bool ConcatConvHWC::isSupported() const
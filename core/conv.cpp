@@ -59,13 +59,28 @@ OIDN_NAMESPACE_BEGIN
 
   void Conv::setWeight(const Ref<Tensor>& weight)
   {
-    if (!weight || weight->getDesc() != weightDesc)
+    if (!weight || weight->getDesc() != getWeightDesc())
       throw std::invalid_argument("invalid convolution weight");
 
     this->weight = weight;
     updateWeight();
   }
 
+  TensorDesc Conv::getWeightScaleDesc() const
+  {
+    return {{weightDesc.getO()}, {weightDesc.getPaddedO()}, TensorLayout::x, DataType::Float32};
+  }
+
+  void Conv::setWeightScale(const Ref<Tensor>& weightScale)
+  {
+    if (getWeightDesc().dataType != DataType::Int8 ||
+        !weightScale || weightScale->getDesc() != getWeightScaleDesc())
+      throw std::invalid_argument("invalid convolution weight scale");
+
+    this->weightScale = weightScale;
+    updateWeightScale();
+  }
+
   void Conv::setBias(const Ref<Tensor>& bias)
   {
     if (!bias || bias->getDesc() != biasDesc)
@@ -84,4 +99,14 @@ OIDN_NAMESPACE_BEGIN
     updateDst();
   }
 
+  OpCost Conv::getCost() const
+  {
+    OpCost cost;
+    cost.bytesRead    = srcDesc.getByteSize() + weightDesc.getByteSize() + biasDesc.getByteSize();
+    cost.bytesWritten = dstDesc.getByteSize();
+    cost.flops        = size_t(2) * weightDesc.getO() * weightDesc.getI() *
+                        weightDesc.getH() * weightDesc.getW() * srcDesc.getH() * srcDesc.getW();
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
@@ -8,6 +8,9 @@
 
 OIDN_NAMESPACE_BEGIN
 
+  class InputProcess;
+  class OutputProcess;
+
   // Activation function
   enum class Activation
   {
@@ -30,7 +33,8 @@ OIDN_NAMESPACE_BEGIN
     TensorDesc biasDesc;
     Activation activation;
     PostOp postOp;
-    bool fastMath; // prefer performance over accuracy
+    bool fastMath;  // prefer performance over accuracy
+    bool quantized; // allow quantized (int8) weights
   };
 
   // Convolution
@@ -42,20 +46,45 @@ OIDN_NAMESPACE_BEGIN
     TensorDesc getDstDesc() const { return dstDesc; }
     Ref<Tensor> getDst() const { return dst; }
 
+    // Returns the descriptor of the weight tensor expected by setWeight, which may differ from the
+    // original one if the weights have to be transformed (e.g. to the Winograd domain)
+    virtual TensorDesc getWeightDesc() const { return weightDesc; }
+
+    // Returns the descriptor of the per-output-channel weight scale tensor expected by
+    // setWeightScale if the weights are quantized
+    TensorDesc getWeightScaleDesc() const;
+
     void setSrc(const Ref<Tensor>& src);
     void setWeight(const Ref<Tensor>& weight);
+    void setWeightScale(const Ref<Tensor>& weightScale);
     void setBias(const Ref<Tensor>& bias);
     void setDst(const Ref<Tensor>& dst);
 
+    // Fuses the input processing producing the source into the convolution if supported. The fused
+    // input processing does nothing when submitted, and the convolution processes the source rows
+    // on the fly, still writing them to the source tensor for any later operations (e.g. the skip
+    // connection of the U-Net), so this improves only the cache locality, not the memory usage.
+    virtual bool fuseInputProcess(const Ref<InputProcess>& inputProcess) { return false; }
+
+    // Fuses the output processing consuming the destination into the convolution if supported. The
+    // fused output processing does nothing when submitted, and the convolution writes the processed
+    // rows directly to the output image, so the destination tensor is not needed.
+    virtual bool fuseOutputProcess(const Ref<OutputProcess>& outputProcess) { return false; }
+
+    const char* getTypeName() const override { return "conv"; }
+    OpCost getCost() const override;
+
   protected:
     virtual void updateSrc() {}
     virtual void updateWeight() {}
+    virtual void updateWeightScale() {}
     virtual void updateBias() {}
     virtual void updateDst() {}
 
     TensorDesc dstDesc;
     Ref<Tensor> src;
     Ref<Tensor> weight;
+    Ref<Tensor> weightScale; // only for quantized weights
     Ref<Tensor> bias;
     Ref<Tensor> dst;
   };
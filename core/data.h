@@ -40,6 +40,19 @@ OIDN_NAMESPACE_BEGIN
     {
       return ptr != nullptr;
     }
+
+    // Returns the FNV-1a hash of the contents, which identifies the data regardless of its address
+    uint64_t getHash() const
+    {
+      const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+      uint64_t hash = 0xcbf29ce484222325;
+      for (size_t i = 0; i < size; ++i)
+      {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+      }
+      return hash;
+    }
   };
 
 OIDN_NAMESPACE_END
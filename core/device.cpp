@@ -92,6 +92,9 @@ OIDN_NAMESPACE_BEGIN
     // Get default values from environment variables
     if (getEnvVar("OIDN_VERBOSE", verbose))
       error.setVerbose(verbose);
+    getEnvVar("OIDN_WEIGHT_CACHE_DIR", weightCacheDir);
+    getEnvVar("OIDN_PROFILING", profiling);
+    getEnvVar("OIDN_PIPELINE_TILES", tilePipelining);
   }
 
   void Device::setError(Device* device, Error code, const std::string& message)
@@ -191,6 +194,8 @@ OIDN_NAMESPACE_BEGIN
       return OIDN_VERSION_PATCH;
     else if (name == "verbose")
       return verbose;
+    else if (name == "profiling")
+      return profiling;
     else if (name == "systemMemorySupported")
       return systemMemorySupported;
     else if (name == "managedMemorySupported")
@@ -213,12 +218,58 @@ OIDN_NAMESPACE_BEGIN
       else if (verbose != value)
         printWarning("OIDN_VERBOSE environment variable overrides device parameter");
     }
+    else if (name == "profiling")
+    {
+      if (!isEnvVar("OIDN_PROFILING"))
+        profiling = value;
+      else if (profiling != bool(value))
+        printWarning("OIDN_PROFILING environment variable overrides device parameter");
+    }
+    else
+      printWarning("unknown device parameter or type mismatch: '" + name + "'");
+
+    dirty = true;
+  }
+
+  const char* Device::getString(const std::string& name)
+  {
+    if (name == "weightCacheDir")
+      return weightCacheDir.c_str();
+    else
+      throw Exception(Error::InvalidArgument, "unknown device parameter or type mismatch: '" + name + "'");
+  }
+
+  void Device::setString(const std::string& name, const std::string& value)
+  {
+    if (name == "weightCacheDir")
+    {
+      if (!isEnvVar("OIDN_WEIGHT_CACHE_DIR"))
+        weightCacheDir = value;
+      else if (weightCacheDir != value)
+        printWarning("OIDN_WEIGHT_CACHE_DIR environment variable overrides device parameter");
+    }
     else
       printWarning("unknown device parameter or type mismatch: '" + name + "'");
 
     dirty = true;
   }
 
+  bool Device::getTunedTileSize(const std::string& key, int& tileH, int& tileW) const
+  {
+    auto tileSizeIter = tunedTileSizes.find(key);
+    if (tileSizeIter == tunedTileSizes.end())
+      return false;
+
+    tileH = tileSizeIter->second.first;
+    tileW = tileSizeIter->second.second;
+    return true;
+  }
+
+  void Device::setTunedTileSize(const std::string& key, int tileH, int tileW)
+  {
+    tunedTileSizes[key] = std::make_pair(tileH, tileW);
+  }
+
   void Device::commit()
   {
     if (isCommitted())
@@ -235,6 +286,10 @@ OIDN_NAMESPACE_BEGIN
 
     init();
 
+    numStreams = max(numStreams, 1);
+    for (int i = 0; i < numStreams; ++i)
+      streamMutexes.emplace_back(new std::mutex);
+
     if (isVerbose())
       std::cout << std::endl;
 
@@ -11,6 +11,7 @@
 #include "tensor_layout.h"
 #include "data.h"
 #include <functional>
+#include <unordered_map>
 
 OIDN_NAMESPACE_BEGIN
 
@@ -67,6 +68,8 @@ OIDN_NAMESPACE_BEGIN
 
     virtual int getInt(const std::string& name);
     virtual void setInt(const std::string& name, int value);
+    virtual const char* getString(const std::string& name);
+    virtual void setString(const std::string& name, const std::string& value);
 
     bool isCommitted() const { return committed; }
     void checkCommitted();
@@ -94,6 +97,15 @@ OIDN_NAMESPACE_BEGIN
 
     oidn_inline std::mutex& getMutex() { return mutex; }
 
+    // Streams in which filters are executed concurrently, without locking the whole device; each
+    // filter submits to one stream, which has its own mutex and scratch memory
+    int getNumStreams() const { return int(streamMutexes.size()); }
+    int newStreamID() { return (nextStreamID++) % getNumStreams(); }
+    oidn_inline std::mutex& getStreamMutex(int streamID) { return *streamMutexes[streamID]; }
+
+    // Sets the stream to which the calling thread submits commands (-1 for none)
+    virtual void setStream(int streamID) {}
+
     // Native tensor layout
     DataType getTensorDataType() const { return tensorDataType; }
     DataType getWeightDataType() const { return weightDataType; }
@@ -103,6 +115,19 @@ OIDN_NAMESPACE_BEGIN
     int getMinTileAlignment() const { return minTileAlignment; }
     virtual bool needWeightAndBiasOnDevice() const { return true; }
 
+    // Directory of the on-disk cache of reordered weights (disabled if empty)
+    const std::string& getWeightCacheDir() const { return weightCacheDir; }
+
+    // Per-operation profiling of filter executions (serializes execution)
+    bool isProfiling() const { return profiling; }
+
+    // Concurrent execution of consecutive filter tiles with two model instances
+    bool isTilePipeliningEnabled() const { return tilePipelining; }
+
+    // Tile sizes selected by the filter tile size autotuner for each filter configuration
+    bool getTunedTileSize(const std::string& key, int& tileH, int& tileW) const;
+    void setTunedTileSize(const std::string& key, int tileH, int tileW);
+
     // Memory
     virtual Storage getPtrStorage(const void* ptr) { return Storage::Undefined; }
     bool isSystemMemorySupported()  const { return systemMemorySupported; }
@@ -143,6 +168,12 @@ OIDN_NAMESPACE_BEGIN
     int tensorBlockC = 1;
     int minTileAlignment = 1; // minimum spatial tile alignment in pixels
 
+    int numStreams = 1; // supported only by some devices
+    std::string weightCacheDir;
+    bool profiling = false;
+    bool tilePipelining = true;
+    std::unordered_map<std::string, std::pair<int, int>> tunedTileSizes;
+
     bool systemMemorySupported  = false;
     bool managedMemorySupported = false;
     ExternalMemoryTypeFlags externalMemoryTypes;
@@ -154,6 +185,8 @@ OIDN_NAMESPACE_BEGIN
   private:
     // Thread-safety
     std::mutex mutex;
+    std::vector<std::unique_ptr<std::mutex>> streamMutexes;
+    int nextStreamID = 0;
 
     // Error handling
     struct ErrorState
@@ -14,6 +14,14 @@ OIDN_NAMESPACE_BEGIN
     virtual Ref<Device> newDevice(const Ref<PhysicalDevice>& physicalDevice) = 0;
   };
 
+  class CPUDeviceFactoryBase : public DeviceFactory
+  {
+  public:
+    using DeviceFactory::newDevice;
+
+    virtual Ref<Device> newDevice(void* const* taskArenas, int numArenas) = 0;
+  };
+
   class SYCLDeviceFactoryBase : public DeviceFactory
   {
   public:
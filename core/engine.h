@@ -84,6 +84,15 @@ OIDN_NAMESPACE_BEGIN
     virtual void submitHostFunc(std::function<void()>&& f,
                                 const Ref<CancellationToken>& ct = nullptr) = 0;
 
+    // Submits the commands of each function such that the commands of different functions may be
+    // executed concurrently, while the commands of each function are still executed in order
+    virtual bool isConcurrentSubmitSupported() const { return false; }
+    virtual void submitConcurrent(const std::vector<std::function<void()>>& funcs)
+    {
+      for (const auto& f : funcs)
+        f();
+    }
+
     // Issues all previously submitted commands (does not block)
     virtual void flush() {}
 
@@ -6,7 +6,8 @@
 OIDN_NAMESPACE_BEGIN
 
   Filter::Filter(const Ref<Device>& device)
-    : device(device) {}
+    : device(device),
+      streamID(device->newStreamID()) {}
 
   Filter::~Filter()
   {
@@ -20,6 +21,12 @@ OIDN_NAMESPACE_BEGIN
     progressUserPtr = userPtr;
   }
 
+  void Filter::setProfilingFunction(ProfilingFunction func, void* userPtr)
+  {
+    profilingFunc = func;
+    profilingUserPtr = userPtr;
+  }
+
   void Filter::setParam(int& dst, int src)
   {
     dirtyParam |= dst != src;
@@ -41,7 +48,7 @@ OIDN_NAMESPACE_BEGIN
   void Filter::setParam(Ref<Image>& dst, const Ref<Image>& src)
   {
     // Check whether the image is accessible by the device
-    if (src && *src && !device->isSystemMemorySupported())
+    if (src && *src && !src->isStream() && !device->isSystemMemorySupported())
     {
       const Storage storage = src->getBuffer() ? src->getBuffer()->getStorage()
                                                : device->getPtrStorage(src->getPtr());
@@ -53,7 +60,8 @@ OIDN_NAMESPACE_BEGIN
     dirtyParam |= (!dst && src && *src) || (dst && (!src || !(*src))) ||
                   (dst && src && *src &&
                    ((dst->getW() != src->getW()) || (dst->getH() != src->getH()) ||
-                    (dst->getFormat() != src->getFormat())));
+                    (dst->getFormat() != src->getFormat()) ||
+                    (dst->isStream() != src->isStream())));
 
     if (src && *src)
       dst = src;
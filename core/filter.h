@@ -16,6 +16,7 @@ OIDN_NAMESPACE_BEGIN
     ~Filter();
 
     Device* getDevice() const { return device.get(); }
+    int getStreamID() const { return streamID; }
 
     virtual void setImage(const std::string& name, const Ref<Image>& image) = 0;
     virtual void unsetImage(const std::string& name) = 0;
@@ -28,6 +29,7 @@ OIDN_NAMESPACE_BEGIN
     virtual float getFloat(const std::string& name) = 0;
 
     void setProgressMonitorFunction(ProgressMonitorFunction func, void* userPtr);
+    void setProfilingFunction(ProfilingFunction func, void* userPtr);
 
     virtual void commit() = 0;
     virtual void execute(SyncMode sync = SyncMode::Blocking) = 0;
@@ -42,10 +44,14 @@ OIDN_NAMESPACE_BEGIN
     void removeParam(Data& dst);
 
     Ref<Device> device;
+    int streamID; // stream in which the filter is executed
 
     ProgressMonitorFunction progressFunc = nullptr;
     void* progressUserPtr = nullptr;
 
+    ProfilingFunction profilingFunc = nullptr;
+    void* profilingUserPtr = nullptr;
+
     bool dirty = true;
     bool dirtyParam = true;
   };
@@ -1,26 +1,37 @@
 // Copyright 2018 Intel Corporation
 // SPDX-License-Identifier: Apache-2.0
 
-//#define OIDN_MICROBENCH 1000 // number of microbenchmark iterations
-
 #include "graph.h"
 #include "concat_conv_chw.h"
 #include "concat_conv_hwc.h"
 #include "tensor_reorder.h"
-#if defined(OIDN_MICROBENCH)
-  #include "common/timer.h"
-#endif
 
 OIDN_NAMESPACE_BEGIN
 
   Graph::Graph(Engine* engine,
                const std::shared_ptr<TensorMap>& constTensors,
                const std::shared_ptr<TensorMap>& cachedConstTensors,
-               bool fastMath)
+               bool fastMath,
+               bool quantized)
     : engine(engine),
       constTensors(constTensors),
       cachedConstTensors(cachedConstTensors),
-      fastMath(fastMath) {}
+      fastMath(fastMath),
+      quantized(quantized) {}
+
+  // Returns the name of the final weights of a convolution, which depends on the transformation
+  // required by the convolution
+  static std::string getConvWeightName(const std::string& weightName,
+                                       const TensorDesc& finalWeightDesc,
+                                       const TensorDesc& convWeightDesc)
+  {
+    if (convWeightDesc.dataType == DataType::Int8)
+      return weightName + ".int8";
+    else if (convWeightDesc != finalWeightDesc)
+      return weightName + ".winograd";
+    else
+      return weightName;
+  }
 
   Ref<InputProcess> Graph::addInputProcess(const std::string& name,
                                            const TensorDims& srcDims,
@@ -49,11 +60,24 @@ OIDN_NAMESPACE_BEGIN
     auto srcAlloc = tensorAllocs[srcOp.get()];
     auto op = engine->newOutputProcess({srcAlloc->desc, transferFunc, hdr, snorm});
     op->setName(name);
+
+    // Try to fuse the output processing into the last convolution, which eliminates the source
+    // tensor and the separate pass
+    if (auto conv = dynamicRefCast<Conv>(srcOp))
+    {
+      if (conv->fuseOutputProcess(op))
+      {
+        srcAlloc->elided = true;
+        tensorScratchPlanner.setAllocByteSize(srcAlloc->id, 0);
+      }
+    }
+
     addOp(op, {srcOp});
 
     lazyInits.push_back([=]()
     {
-      op->setSrc(srcAlloc->tensor);
+      if (!srcAlloc->elided)
+        op->setSrc(srcAlloc->tensor);
     });
 
     return op;
@@ -106,23 +130,51 @@ OIDN_NAMESPACE_BEGIN
                                 device->getTensorDataType()};
 
     auto srcAlloc = tensorAllocs[srcOp.get()];
-    auto conv = engine->newConv({srcAlloc->desc, finalWeightDesc, finalBiasDesc, activation, postOp, fastMath});
+    auto conv = engine->newConv({srcAlloc->desc, finalWeightDesc, finalBiasDesc, activation, postOp,
+                                 fastMath, quantized});
     conv->setName(name);
+
+    // Try to fuse the input processing into the first convolution to convolve the processed rows
+    // while they are still in the cache. The source tensor is still allocated for the later ops.
+    if (auto inputProcess = dynamicRefCast<InputProcess>(srcOp))
+      conv->fuseInputProcess(inputProcess);
+
     auto dstAlloc = addOp(conv, {srcOp}, conv->getDstDesc());
 
+    // The convolution may require the weights to be transformed to the Winograd domain or quantized
+    const TensorDesc convWeightDesc = conv->getWeightDesc();
+    const std::string convWeightName = getConvWeightName(weightName, finalWeightDesc, convWeightDesc);
+    const bool isQuantized = convWeightDesc.dataType == DataType::Int8;
+    const TensorDesc weightScaleDesc = conv->getWeightScaleDesc();
+    const std::string weightScaleName = convWeightName + "_scale";
+
     lazyInits.push_back([=]()
     {
       conv->setSrc(srcAlloc->tensor);
-      conv->setDst(dstAlloc->tensor);
+      if (!dstAlloc->elided)
+        conv->setDst(dstAlloc->tensor);
 
-      Ref<Tensor> finalWeight = getCachedConstTensor(weightName, finalWeightDesc);
-      if (!finalWeight)
+      Ref<Tensor> finalWeight = getCachedConstTensor(convWeightName, convWeightDesc);
+      Ref<Tensor> finalWeightScale;
+      if (isQuantized)
+        finalWeightScale = getCachedConstTensor(weightScaleName, weightScaleDesc);
+
+      if (!finalWeight || (isQuantized && !finalWeightScale))
       {
-        finalWeight = makeRef<HostTensor>(finalWeightDesc);
-        reorderWeight(*weight, *finalWeight);
+        Ref<Tensor> srcWeightScale;
+        Ref<Tensor> srcWeight = getSourceWeight(weightName, isQuantized, srcWeightScale);
+        finalWeight = makeRef<HostTensor>(srcWeightScale ? convWeightDesc : finalWeightDesc);
+        reorderWeight(*srcWeight, *finalWeight);
+        transformWeight(finalWeight, finalWeightScale, srcWeightScale, convWeightDesc, weightScaleDesc);
         if (device->needWeightAndBiasOnDevice())
+        {
           finalWeight = finalWeight->toDevice(engine);
-        setCachedConstTensor(weightName, finalWeight);
+          if (finalWeightScale)
+            finalWeightScale = finalWeightScale->toDevice(engine);
+        }
+        setCachedConstTensor(convWeightName, finalWeight);
+        if (finalWeightScale)
+          setCachedConstTensor(weightScaleName, finalWeightScale);
       }
 
       Ref<Tensor> finalBias = getCachedConstTensor(biasName, finalBiasDesc);
@@ -136,10 +188,14 @@ OIDN_NAMESPACE_BEGIN
       }
 
       conv->setWeight(finalWeight);
+      if (isQuantized)
+        conv->setWeightScale(finalWeightScale);
       conv->setBias(finalBias);
     });
 
-    privateByteSize += finalWeightDesc.getByteSize() + finalBiasDesc.getByteSize();
+    privateByteSize += convWeightDesc.getByteSize() + finalBiasDesc.getByteSize();
+    if (isQuantized)
+      privateByteSize += weightScaleDesc.getByteSize();
     return conv;
   }
 
@@ -179,7 +235,8 @@ OIDN_NAMESPACE_BEGIN
                                 TensorLayout::x,
                                 device->getTensorDataType()};
 
-    ConcatConvDesc concatConvDesc{src1Desc, src2Desc, finalWeightDesc, finalBiasDesc, activation, fastMath};
+    ConcatConvDesc concatConvDesc{src1Desc, src2Desc, finalWeightDesc, finalBiasDesc, activation,
+                                  fastMath, quantized};
 
     if (device->getTensorLayout() == TensorLayout::hwc)
     {
@@ -202,9 +259,11 @@ OIDN_NAMESPACE_BEGIN
           finalWeight1 = makeRef<HostTensor>(concatConv->getWeight1Desc());
           finalWeight2 = makeRef<HostTensor>(concatConv->getWeight2Desc());
 
-          reorderWeight(*weight, 0, src1Desc.getC(),
+          Ref<Tensor> srcWeightScale;
+          Ref<Tensor> srcWeight = getSourceWeight(weightName, false, srcWeightScale);
+          reorderWeight(*srcWeight, 0, src1Desc.getC(),
                         *finalWeight1, 0, src1Desc.getPaddedC());
-          reorderWeight(*weight, src1Desc.getC(), src2Desc.getC(),
+          reorderWeight(*srcWeight, src1Desc.getC(), src2Desc.getC(),
                         *finalWeight2, 0, src2Desc.getPaddedC());
 
           if (device->needWeightAndBiasOnDevice())
@@ -242,25 +301,45 @@ OIDN_NAMESPACE_BEGIN
       concatConv->setName(name);
       auto dstAlloc = addOp(concatConv, {src1Op, src2Op}, concatConv->getDstDesc(), true);
 
+      const TensorDesc convWeightDesc = concatConv->getWeightDesc();
+      const std::string convWeightName = getConvWeightName(weightName, finalWeightDesc, convWeightDesc);
+      const bool isQuantized = convWeightDesc.dataType == DataType::Int8;
+      const TensorDesc weightScaleDesc = concatConv->getWeightScaleDesc();
+      const std::string weightScaleName = convWeightName + "_scale";
+
       lazyInits.push_back([=]()
       {
         concatConv->setSrc(src1Alloc->tensor, src2Alloc->tensor);
         concatConv->setDst(dstAlloc->tensor);
 
-        Ref<Tensor> finalWeight = getCachedConstTensor(weightName, finalWeightDesc);
-        if (!finalWeight)
+        Ref<Tensor> finalWeight = getCachedConstTensor(convWeightName, convWeightDesc);
+        Ref<Tensor> finalWeightScale;
+        if (isQuantized)
+          finalWeightScale = getCachedConstTensor(weightScaleName, weightScaleDesc);
+
+        if (!finalWeight || (isQuantized && !finalWeightScale))
         {
-          finalWeight = makeRef<HostTensor>(finalWeightDesc);
+          Ref<Tensor> srcWeightScale;
+          Ref<Tensor> srcWeight = getSourceWeight(weightName, isQuantized, srcWeightScale);
+          finalWeight = makeRef<HostTensor>(srcWeightScale ? convWeightDesc : finalWeightDesc);
 
-          reorderWeight(*weight, 0, src1Desc.getC(),
+          reorderWeight(*srcWeight, 0, src1Desc.getC(),
                         *finalWeight, 0, src1Desc.getPaddedC());
-          reorderWeight(*weight, src1Desc.getC(), src2Desc.getC(),
+          reorderWeight(*srcWeight, src1Desc.getC(), src2Desc.getC(),
                         *finalWeight, src1Desc.getPaddedC(), src2Desc.getPaddedC());
 
+          transformWeight(finalWeight, finalWeightScale, srcWeightScale, convWeightDesc, weightScaleDesc);
+
           if (device->needWeightAndBiasOnDevice())
+          {
             finalWeight = finalWeight->toDevice(engine);
+            if (finalWeightScale)
+              finalWeightScale = finalWeightScale->toDevice(engine);
+          }
 
-          setCachedConstTensor(weightName, finalWeight);
+          setCachedConstTensor(convWeightName, finalWeight);
+          if (finalWeightScale)
+            setCachedConstTensor(weightScaleName, finalWeightScale);
         }
 
         Ref<Tensor> finalBias = getCachedConstTensor(biasName, finalBiasDesc);
@@ -274,10 +353,14 @@ OIDN_NAMESPACE_BEGIN
         }
 
         concatConv->setWeight(finalWeight);
+        if (isQuantized)
+          concatConv->setWeightScale(finalWeightScale);
         concatConv->setBias(finalBias);
       });
 
-      privateByteSize += finalWeightDesc.getByteSize() + finalBiasDesc.getByteSize();
+      privateByteSize += convWeightDesc.getByteSize() + finalBiasDesc.getByteSize();
+      if (isQuantized)
+        privateByteSize += weightScaleDesc.getByteSize();
       return concatConv;
     }
   }
@@ -357,20 +440,25 @@ OIDN_NAMESPACE_BEGIN
 
   void Graph::planAllocs()
   {
-    tensorScratchPlanner.commit();
-
-    // Compute the size of the operation scratch
-    size_t opScratchByteSize = 0;
-    for (const auto& op : ops)
-      opScratchByteSize = max(opScratchByteSize, op->getScratchByteSize());
-    opScratchByteSize = round_up(opScratchByteSize, tensorScratchPlanner.getByteAlignment());
+    // Plan the operation scratch together with the tensors, so it can reuse the memory of tensors
+    // that are not used by the operation
+    for (int opID = int(opScratchAllocIDs.size()); opID < int(ops.size()); ++opID)
+    {
+      const size_t opScratchByteSize = ops[opID]->getScratchByteSize();
+      if (opScratchByteSize > 0)
+      {
+        const auto opScratchByteSizeAndAlignment =
+          engine->getBufferByteSizeAndAlignment(opScratchByteSize, Storage::Device);
+        opScratchAllocIDs.push_back(tensorScratchPlanner.newAlloc(opID, opScratchByteSizeAndAlignment));
+      }
+      else
+        opScratchAllocIDs.push_back(-1);
+    }
 
-    // Compute the size of the tensor scratch
-    tensorScratchByteOffset = opScratchByteSize;
-    size_t tensorScratchByteSize = round_up(tensorScratchPlanner.getByteSize(), memoryAlignment);
+    tensorScratchPlanner.commit();
 
     // Compute the total scratch size
-    scratchByteSize = opScratchByteSize + tensorScratchByteSize;
+    scratchByteSize = round_up(tensorScratchPlanner.getByteSize(), memoryAlignment);
 
     dirty = false;
   }
@@ -406,6 +494,7 @@ OIDN_NAMESPACE_BEGIN
   {
     lazyInits.clear();
     tensorAllocs.clear();
+    opScratchAllocIDs.clear();
     tensorScratchPlanner.clear();
   }
 
@@ -420,7 +509,6 @@ OIDN_NAMESPACE_BEGIN
     scratchByteSize = 0;
     privateByteSize = 0;
     workAmount = 0;
-    tensorScratchByteOffset = 0;
     dirty = false;
   }
 
@@ -432,19 +520,36 @@ OIDN_NAMESPACE_BEGIN
     for (const auto& opTensorAllocPair : tensorAllocs)
     {
       auto& alloc = opTensorAllocPair.second;
+      if (alloc->elided)
+        continue;
       const size_t byteOffset = tensorScratchPlanner.getAllocByteOffset(alloc->id);
-      alloc->tensor = scratch->newTensor(alloc->desc, tensorScratchByteOffset + byteOffset);
+      alloc->tensor = scratch->newTensor(alloc->desc, byteOffset);
     }
 
     for (auto& lazyInit : lazyInits)
       lazyInit();
 
-    for (auto& op : ops)
+    for (size_t opID = 0; opID < ops.size(); ++opID)
     {
-      op->setScratch(scratch);
+      // Operations without their own scratch get the whole scratch buffer (e.g. for tracking)
+      auto& op = ops[opID];
+      const int opScratchAllocID = opScratchAllocIDs[opID];
+      if (opScratchAllocID >= 0)
+      {
+        const size_t byteOffset = tensorScratchPlanner.getAllocByteOffset(opScratchAllocID);
+        op->setScratch(scratch->newBuffer(op->getScratchByteSize(), byteOffset));
+      }
+      else
+        op->setScratch(scratch);
       op->finalize();
     }
 
+    if (engine->getDevice()->isVerbose(2))
+    {
+      std::cout << "Scratch size: " << tensorScratchPlanner.getByteSize()
+                << " (lower bound: " << tensorScratchPlanner.getLowerBoundByteSize() << ")" << std::endl;
+    }
+
     cleanup();
     constTensors.reset();
     cachedConstTensors.reset();
@@ -453,31 +558,23 @@ OIDN_NAMESPACE_BEGIN
   }
 
   void Graph::submit(const Ref<Progress>& progress)
+  {
+    submit(progress, 0, ops.size());
+  }
+
+  void Graph::submit(const Ref<Progress>& progress, size_t beginOp, size_t endOp)
   {
     if (!finalized)
       throw std::logic_error("graph not finalized");
+    if (beginOp > endOp || endOp > ops.size())
+      throw std::out_of_range("graph op range out of bounds");
 
-  #if defined(OIDN_MICROBENCH)
-    double totalTime = 0;
-    std::cerr << std::endl;
-    std::cerr << "op,name,msec" << std::endl;
-  #endif
-
-    for (size_t i = 0; i < ops.size(); ++i)
+    for (size_t i = beginOp; i < endOp; ++i)
     {
-      ops[i]->submit(progress);
-
-    #if defined(OIDN_MICROBENCH)
-      engine->wait();
-      const int numRuns = OIDN_MICROBENCH;
-      Timer timer;
-      for (int j = 0; j < numRuns; ++j)
+      if (profiler)
+        profiler->submit(ops[i].get(), progress);
+      else
         ops[i]->submit(progress);
-      engine->wait();
-      const double time = timer.query() / numRuns;
-      std::cerr << i << "," << ops[i]->getName() << "," << time * 1000 << std::endl;
-      totalTime += time;
-    #endif
 
     #if 0
       // Dump
@@ -503,10 +600,6 @@ OIDN_NAMESPACE_BEGIN
       }
     #endif
     }
-
-  #if defined(OIDN_MICROBENCH)
-    std::cerr << ",total," << totalTime * 1000 << std::endl;
-  #endif
   }
 
   Ref<Tensor> Graph::getCachedConstTensor(const std::string& name, const TensorDesc& desc)
@@ -527,4 +620,57 @@ OIDN_NAMESPACE_BEGIN
       (*cachedConstTensors)[name] = tensor;
   }
 
+  // Returns the original weights of a convolution in a format supported by reorderWeight. Quantized
+  // (int8) weights are returned as is with their per-output-channel scales if the convolution is
+  // quantized too, otherwise they are dequantized to FP32.
+  Ref<Tensor> Graph::getSourceWeight(const std::string& weightName, bool quantized, Ref<Tensor>& weightScale)
+  {
+    weightScale = nullptr;
+    Ref<Tensor> weight = (*constTensors)[weightName];
+    if (weight->getDataType() != DataType::Int8)
+      return weight;
+
+    auto scaleIter = constTensors->find(weightName + "_scale");
+    if (scaleIter == constTensors->end())
+      throw Exception(Error::InvalidOperation, "missing scale for quantized weight '" + weightName + "'");
+
+    if (quantized)
+    {
+      weightScale = scaleIter->second;
+      return weight;
+    }
+
+    Ref<Tensor> dequantizedWeight =
+      makeRef<HostTensor>(TensorDesc(weight->getDims(), TensorLayout::oihw, DataType::Float32));
+    dequantizeWeight(*weight, *scaleIter->second, *dequantizedWeight);
+    return dequantizedWeight;
+  }
+
+  // Transforms reordered weights to the format expected by the convolution (e.g. to the Winograd
+  // domain or quantized to int8 with per-output-channel scales). Weights that are already quantized
+  // keep their original scales.
+  void Graph::transformWeight(Ref<Tensor>& weight, Ref<Tensor>& weightScale, const Ref<Tensor>& srcWeightScale,
+                              const TensorDesc& convWeightDesc, const TensorDesc& weightScaleDesc)
+  {
+    if (weight->getDesc() == convWeightDesc)
+    {
+      if (srcWeightScale)
+      {
+        weightScale = makeRef<HostTensor>(weightScaleDesc);
+        reorderWeightScale(*srcWeightScale, *weightScale);
+      }
+      return;
+    }
+
+    Ref<Tensor> convWeight = makeRef<HostTensor>(convWeightDesc);
+    if (convWeightDesc.dataType == DataType::Int8)
+    {
+      weightScale = makeRef<HostTensor>(weightScaleDesc);
+      quantizeWeight(*weight, *convWeight, *weightScale);
+    }
+    else
+      transformWinogradWeight(*weight, *convWeight);
+    weight = convWeight;
+  }
+
 OIDN_NAMESPACE_END
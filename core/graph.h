@@ -8,6 +8,7 @@
 #include "pool.h"
 #include "upsample.h"
 #include "progress.h"
+#include "profiler.h"
 #include "arena_planner.h"
 #include <vector>
 #include <unordered_map>
@@ -20,7 +21,8 @@ OIDN_NAMESPACE_BEGIN
     Graph(Engine* engine,
           const std::shared_ptr<TensorMap>& constTensors,
           const std::shared_ptr<TensorMap>& cachedConstTensors,
-          bool fastMath = false);
+          bool fastMath = false,
+          bool quantized = false);
 
     Engine* getEngine() const override { return engine; }
 
@@ -63,6 +65,15 @@ OIDN_NAMESPACE_BEGIN
     void finalize() override;
     void submit(const Ref<Progress>& progress) override;
 
+    // Submits only the operations in the [beginOp, endOp) range
+    size_t getNumOps() const { return ops.size(); }
+    void submit(const Ref<Progress>& progress, size_t beginOp, size_t endOp);
+
+    const char* getTypeName() const override { return "graph"; }
+
+    // Optionally profiles each operation on submission
+    void setProfiler(const std::shared_ptr<Profiler>& profiler) { this->profiler = profiler; }
+
   private:
     // Temporary tensor allocation
     struct TensorAlloc
@@ -73,6 +84,9 @@ OIDN_NAMESPACE_BEGIN
       // Set only when planning allocations
       Ref<Tensor> tensor;
 
+      // The tensor is not stored because its producer and consumer operations are fused
+      bool elided = false;
+
       TensorAlloc(const TensorDesc& desc, int id)
         : desc(desc),
           id(id) {}
@@ -92,6 +106,10 @@ OIDN_NAMESPACE_BEGIN
     Ref<Tensor> getCachedConstTensor(const std::string& name, const TensorDesc& desc);
     void setCachedConstTensor(const std::string& name, const Ref<Tensor>& tensor);
 
+    Ref<Tensor> getSourceWeight(const std::string& weightName, bool quantized, Ref<Tensor>& weightScale);
+    void transformWeight(Ref<Tensor>& weight, Ref<Tensor>& weightScale, const Ref<Tensor>& srcWeightScale,
+                         const TensorDesc& convWeightDesc, const TensorDesc& weightScaleDesc);
+
     Engine* engine;
     std::vector<Ref<Op>> ops;
     Ref<Buffer> scratch;        // scratch buffer
@@ -100,15 +118,17 @@ OIDN_NAMESPACE_BEGIN
     size_t workAmount = 0;      // total estimated amount of work for progress monitoring
     bool dirty = false;
     bool finalized = false;
+    std::shared_ptr<Profiler> profiler;
 
     // Used only while building the graph
-    ArenaPlanner tensorScratchPlanner;  // tensor scratch allocation planner
-    size_t tensorScratchByteOffset = 0; // offset of tensor data in the scratch buffer
+    ArenaPlanner tensorScratchPlanner;  // tensor and op scratch allocation planner
     std::unordered_map<Op*, std::shared_ptr<TensorAlloc>> tensorAllocs;
+    std::vector<int> opScratchAllocIDs;           // scratch allocation ID for each op (-1 if none)
     std::vector<std::function<void()>> lazyInits;  // lazy initialization for ops
     std::shared_ptr<TensorMap> constTensors;       // original weights
     std::shared_ptr<TensorMap> cachedConstTensors; // cached final weights shared with other graphs
-    bool fastMath = false;
+    bool fastMath  = false;
+    bool quantized = false;
   };
 
 OIDN_NAMESPACE_END
@@ -74,6 +74,11 @@ OIDN_NAMESPACE_BEGIN
     this->ptr = static_cast<char*>(buffer->getPtr());
   }
 
+  Image::Image(const ImageStream& stream, Format format, size_t width, size_t height)
+    : ImageDesc(format, width, height),
+      ptr(nullptr),
+      stream(stream) {}
+
   void Image::postRealloc()
   {
     if (buffer)
@@ -82,7 +87,7 @@ OIDN_NAMESPACE_BEGIN
 
   bool Image::overlaps(const Image& other) const
   {
-    if (!*this || !other)
+    if (!*this || !other || isStream() || other.isStream())
       return false;
 
     // If any of the images are not backed by non-shared buffers, we cannot determine whether they
@@ -103,4 +108,16 @@ OIDN_NAMESPACE_BEGIN
     return begin1 < end2 && begin2 < end1;
   }
 
+  Ref<Image> Image::newSubImage(size_t h, size_t w, size_t subHeight, size_t subWidth)
+  {
+    if (h + subHeight > height || w + subWidth > width)
+      throw std::out_of_range("image region is out of bounds");
+
+    const size_t subByteOffset = h * hByteStride + w * wByteStride;
+    if (buffer)
+      return makeRef<Image>(buffer, format, subWidth, subHeight, byteOffset + subByteOffset, wByteStride, hByteStride);
+    else
+      return makeRef<Image>(ptr, format, subWidth, subHeight, subByteOffset, wByteStride, hByteStride);
+  }
+
 OIDN_NAMESPACE_END
\ No newline at end of file
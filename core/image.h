@@ -71,6 +71,13 @@ OIDN_NAMESPACE_BEGIN
     }
   };
 
+  // Callback based access to the rows of an image which is not stored in memory
+  struct ImageStream
+  {
+    ImageStreamFunction func;
+    void* userPtr;
+  };
+
   class Image final : public Memory, private ImageDesc
   {
   public:
@@ -79,6 +86,7 @@ OIDN_NAMESPACE_BEGIN
     Image(const Ref<Buffer>& buffer, const ImageDesc& desc, size_t byteOffset);
     Image(const Ref<Buffer>& buffer, Format format, size_t width, size_t height, size_t byteOffset, size_t pixelByteStride, size_t rowByteStride);
     Image(Engine* engine, Format format, size_t width, size_t height);
+    Image(const ImageStream& stream, Format format, size_t width, size_t height);
 
     void postRealloc() override;
 
@@ -93,7 +101,11 @@ OIDN_NAMESPACE_BEGIN
     using ImageDesc::getDataType;
 
     oidn_inline void* getPtr() const { return ptr; }
-    oidn_inline operator bool() const { return ptr || buffer; }
+    oidn_inline operator bool() const { return ptr || buffer || stream.func; }
+
+    // Streamed images have no data in memory, their rows must be accessed through the stream
+    oidn_inline bool isStream() const { return stream.func != nullptr; }
+    oidn_inline const ImageStream& getStream() const { return stream; }
 
     operator ImageAccessor()
     {
@@ -115,8 +127,12 @@ OIDN_NAMESPACE_BEGIN
     // Determines whether two images overlap in memory
     bool overlaps(const Image& other) const;
 
+    // Returns a view of a rectangular region of the image
+    Ref<Image> newSubImage(size_t h, size_t w, size_t subHeight, size_t subWidth);
+
   private:
     char* ptr; // pointer to the first pixel
+    ImageStream stream{nullptr, nullptr}; // stream of the rows (if not stored in memory)
   };
 
 OIDN_NAMESPACE_END
@@ -14,6 +14,16 @@ OIDN_NAMESPACE_BEGIN
     void setSrc(const Ref<Image>& src) { this->src = src; }
     void setDst(const Ref<Image>& dst) { this->dst = dst; }
 
+    const char* getTypeName() const override { return "image_copy"; }
+
+    OpCost getCost() const override
+    {
+      OpCost cost;
+      if (src)
+        cost.bytesRead = cost.bytesWritten = src->getNumElements() * getFormatSize(src->getFormat());
+      return cost;
+    }
+
   protected:
     void check()
     {
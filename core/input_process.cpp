@@ -71,4 +71,18 @@ OIDN_NAMESPACE_BEGIN
       throw std::out_of_range("input processing source/destination out of bounds");
   }
 
+  OpCost InputProcess::getCost() const
+  {
+    const size_t numPixels = size_t(tile.H) * tile.W;
+    OpCost cost;
+    for (const Image* image : {color.get(), albedo.get(), normal.get()})
+    {
+      if (image)
+        cost.bytesRead += numPixels * getFormatSize(image->getFormat());
+    }
+    cost.bytesWritten = dstDesc.getByteSize();
+    cost.flops        = numPixels * dstDesc.getC() * 4; // transfer function, scaling, sanitization
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
\ No newline at end of file
@@ -33,6 +33,9 @@ OIDN_NAMESPACE_BEGIN
     void setDst(const Ref<Tensor>& dst);
     void setTile(int hSrc, int wSrc, int hDst, int wDst, int H, int W);
 
+    const char* getTypeName() const override { return "input_process"; }
+    OpCost getCost() const override;
+
   protected:
     virtual void updateSrc() {}
     void check();
@@ -0,0 +1,82 @@
+// Copyright 2024 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "mapped_file.h"
+#if !defined(_WIN32)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+OIDN_NAMESPACE_BEGIN
+
+#if defined(_WIN32)
+
+  MappedFile::MappedFile(const std::string& filename)
+  {
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+      throw std::runtime_error("cannot open file: '" + filename + "'");
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+      CloseHandle(fileHandle);
+      throw std::runtime_error("cannot map empty file: '" + filename + "'");
+    }
+    size = size_t(fileSize.QuadPart);
+
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle)
+      ptr = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+    if (!ptr)
+    {
+      if (mappingHandle)
+        CloseHandle(mappingHandle);
+      CloseHandle(fileHandle);
+      throw std::runtime_error("cannot map file: '" + filename + "'");
+    }
+  }
+
+  MappedFile::~MappedFile()
+  {
+    UnmapViewOfFile(ptr);
+    CloseHandle(mappingHandle);
+    CloseHandle(fileHandle);
+  }
+
+#else
+
+  MappedFile::MappedFile(const std::string& filename)
+  {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("cannot open file: '" + filename + "'");
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+      close(fd);
+      throw std::runtime_error("cannot map empty file: '" + filename + "'");
+    }
+    size = size_t(st.st_size);
+
+    // The mapping remains valid after closing the file descriptor
+    void* mappedPtr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mappedPtr == MAP_FAILED)
+      throw std::runtime_error("cannot map file: '" + filename + "'");
+    ptr = mappedPtr;
+  }
+
+  MappedFile::~MappedFile()
+  {
+    munmap(const_cast<void*>(ptr), size);
+  }
+
+#endif
+
+OIDN_NAMESPACE_END
@@ -0,0 +1,34 @@
+// Copyright 2024 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "common/common.h"
+#include "ref.h"
+
+OIDN_NAMESPACE_BEGIN
+
+  // Read-only memory-mapped file
+  class MappedFile final : public RefCount
+  {
+  public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    const void* getPtr() const { return ptr; }
+    size_t getSize() const { return size; }
+
+  private:
+    // Disable copying
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator =(const MappedFile&) = delete;
+
+    const void* ptr = nullptr;
+    size_t size = 0;
+  #if defined(_WIN32)
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = nullptr;
+  #endif
+  };
+
+OIDN_NAMESPACE_END
@@ -8,6 +8,22 @@
 
 OIDN_NAMESPACE_BEGIN
 
+  // Estimated cost of an operation for profiling
+  struct OpCost
+  {
+    size_t bytesRead    = 0;
+    size_t bytesWritten = 0;
+    size_t flops        = 0; // number of floating-point operations
+
+    OpCost& operator +=(const OpCost& other)
+    {
+      bytesRead    += other.bytesRead;
+      bytesWritten += other.bytesWritten;
+      flops        += other.flops;
+      return *this;
+    }
+  };
+
   // Abstract operation class
   class Op : public RefCount
   {
@@ -32,6 +48,13 @@ OIDN_NAMESPACE_BEGIN
     // Returns the estimated amount of work for progress monitoring
     virtual size_t getWorkAmount() const { return 1; }
 
+    // Returns the type name and the estimated cost of the last submission for profiling
+    virtual const char* getTypeName() const = 0;
+    virtual OpCost getCost() const { return {}; }
+
+    // Fused operations are performed by another operation, which is profiled instead
+    virtual bool isFused() const { return false; }
+
     // Name for debugging purposes
     std::string getName() const { return name; }
     void setName(const std::string& name) { this->name = name; }
@@ -42,13 +42,33 @@ OIDN_NAMESPACE_BEGIN
 
   void OutputProcess::check()
   {
-    if (!src || !dst)
-      throw std::logic_error("output processing source/destination not set");
-    if (tile.hSrcBegin + tile.H > src->getH() ||
-        tile.wSrcBegin + tile.W > src->getW() ||
+    if (!src)
+      throw std::logic_error("output processing source not set");
+    checkDst();
+  }
+
+  void OutputProcess::checkDst()
+  {
+    if (!dst)
+      throw std::logic_error("output processing destination not set");
+    if (tile.hSrcBegin + tile.H > srcDesc.getH() ||
+        tile.wSrcBegin + tile.W > srcDesc.getW() ||
         tile.hDstBegin + tile.H > dst->getH() ||
         tile.wDstBegin + tile.W > dst->getW())
       throw std::out_of_range("output processing source/destination out of bounds");
   }
 
+  OpCost OutputProcess::getCost() const
+  {
+    const size_t numPixels = size_t(tile.H) * tile.W;
+    OpCost cost;
+    if (dst)
+    {
+      cost.bytesRead    = numPixels * dst->getC() * getDataTypeSize(srcDesc.dataType);
+      cost.bytesWritten = numPixels * getFormatSize(dst->getFormat());
+      cost.flops        = numPixels * dst->getC() * 4; // inverse transfer function, scaling, sanitization
+    }
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
\ No newline at end of file
@@ -31,8 +31,12 @@ OIDN_NAMESPACE_BEGIN
     void setDst(const Ref<Image>& dst);
     void setTile(int hSrc, int wSrc, int hDst, int wDst, int H, int W);
 
+    const char* getTypeName() const override { return "output_process"; }
+    OpCost getCost() const override;
+
   protected:
     void check();
+    void checkDst(); // checks only the destination and the tile (e.g. if the source is fused)
 
     Ref<Tensor> src;
     Ref<Image> dst;
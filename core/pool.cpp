@@ -34,4 +34,13 @@ OIDN_NAMESPACE_BEGIN
     updateDst();
   }
 
+  OpCost Pool::getCost() const
+  {
+    OpCost cost;
+    cost.bytesRead    = srcDesc.getByteSize();
+    cost.bytesWritten = dstDesc.getByteSize();
+    cost.flops        = srcDesc.getNumElements(); // comparisons
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
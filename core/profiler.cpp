@@ -0,0 +1,99 @@
+// Copyright 2018 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "profiler.h"
+#include "common/timer.h"
+#include <iomanip>
+
+OIDN_NAMESPACE_BEGIN
+
+  void Profiler::reset()
+  {
+    entries.clear();
+    entryIndices.clear();
+    records.clear();
+  }
+
+  void Profiler::submit(Op* op, const Ref<Progress>& progress)
+  {
+    if (op->isFused())
+    {
+      op->submit(progress);
+      return;
+    }
+
+    Engine* engine = op->getEngine();
+    engine->wait();
+
+    Timer timer;
+    op->submit(progress);
+    engine->wait();
+    const double time = timer.query();
+
+    const std::string name = op->getName();
+    auto indexIter = entryIndices.find(name);
+    size_t index;
+    if (indexIter == entryIndices.end())
+    {
+      index = entries.size();
+      entryIndices[name] = index;
+      entries.emplace_back();
+      entries.back().name = name;
+      entries.back().type = op->getTypeName();
+    }
+    else
+      index = indexIter->second;
+
+    Entry& entry = entries[index];
+    entry.count++;
+    entry.time += time;
+    entry.cost += op->getCost();
+  }
+
+  const std::vector<ProfileRecord>& Profiler::getRecords()
+  {
+    records.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+      const Entry& entry = entries[i];
+      ProfileRecord& record = records[i];
+      record.name  = entry.name.c_str();
+      record.type  = entry.type.c_str();
+      record.count = entry.count;
+      record.time  = entry.time;
+      record.bytesRead    = entry.cost.bytesRead;
+      record.bytesWritten = entry.cost.bytesWritten;
+      record.flops        = entry.cost.flops;
+    }
+    return records;
+  }
+
+  double Profiler::getTotalTime() const
+  {
+    double totalTime = 0;
+    for (const auto& entry : entries)
+      totalTime += entry.time;
+    return totalTime;
+  }
+
+  void Profiler::print() const
+  {
+    std::cout << "  Profile:" << std::endl;
+    for (const auto& entry : entries)
+    {
+      std::cout << "    " << std::left << std::setw(20) << entry.name << std::right
+                << " " << std::setw(14) << entry.type
+                << " x" << std::setw(3) << entry.count
+                << std::fixed << std::setprecision(3)
+                << " " << std::setw(9) << entry.time * 1000 << " msec";
+      if (entry.time > 0 && entry.cost.flops > 0)
+        std::cout << " " << std::setw(8) << entry.cost.flops / entry.time * 1e-9 << " GFLOPS";
+      if (entry.time > 0)
+        std::cout << " " << std::setw(8)
+                  << (entry.cost.bytesRead + entry.cost.bytesWritten) / entry.time * 1e-9 << " GB/s";
+      std::cout << std::defaultfloat << std::endl;
+    }
+    std::cout << "    total: " << getTotalTime() * 1000 << " msec" << std::endl;
+  }
+
+OIDN_NAMESPACE_END
@@ -0,0 +1,43 @@
+// Copyright 2018 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "op.h"
+#include <vector>
+#include <unordered_map>
+
+OIDN_NAMESPACE_BEGIN
+
+  // Measures the execution time and estimated cost of operations, aggregated by operation name
+  // Each operation is executed synchronously, which serializes the engine
+  class Profiler
+  {
+  public:
+    void reset();
+
+    // Submits the operation and waits for its completion, recording its time and cost
+    void submit(Op* op, const Ref<Progress>& progress = nullptr);
+
+    // Returns the records in order of first submission, valid until the next reset
+    const std::vector<ProfileRecord>& getRecords();
+
+    double getTotalTime() const;
+    void print() const;
+
+  private:
+    struct Entry
+    {
+      std::string name;
+      std::string type;
+      int count = 0;
+      double time = 0;
+      OpCost cost;
+    };
+
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> entryIndices;
+    std::vector<ProfileRecord> records;
+  };
+
+OIDN_NAMESPACE_END
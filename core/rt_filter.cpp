@@ -73,7 +73,10 @@ OIDN_NAMESPACE_BEGIN
   void RTFilter::setImage(const std::string& name, const Ref<Image>& image)
   {
     if (name == "color")
+    {
       setParam(color, image);
+      autoexposureCached = false; // the contents may have changed even if the image is the same
+    }
     else if (name == "albedo")
       setParam(albedo, image);
     else if (name == "normal")
@@ -89,7 +92,10 @@ OIDN_NAMESPACE_BEGIN
   void RTFilter::unsetImage(const std::string& name)
   {
     if (name == "color")
+    {
       removeParam(color);
+      autoexposureCached = false;
+    }
     else if (name == "albedo")
       removeParam(albedo);
     else if (name == "normal")
@@ -110,6 +116,8 @@ OIDN_NAMESPACE_BEGIN
       setParam(srgb, value);
     else if (name == "cleanAux")
       setParam(cleanAux, value);
+    else if (name == "prefilterAux")
+      setParam(prefilterAux, value);
     else
       UNetFilter::setInt(name, value);
 
@@ -124,6 +132,8 @@ OIDN_NAMESPACE_BEGIN
       return srgb;
     else if (name == "cleanAux")
       return cleanAux;
+    else if (name == "prefilterAux")
+      return prefilterAux;
     else
       return UNetFilter::getInt(name);
   }
@@ -32,9 +32,17 @@ OIDN_NAMESPACE_BEGIN
   void RTLightmapFilter::setImage(const std::string& name, const Ref<Image>& image)
   {
     if (name == "color")
+    {
       setParam(color, image);
+      autoexposureCached = false; // the contents may have changed even if the image is the same
+    }
     else if (name == "output")
       setParam(output, image);
+    else if (name == "coverage")
+    {
+      setParam(coverage, image);
+      coverageDirty = true; // the contents may have changed even if the image is the same
+    }
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -44,9 +52,14 @@ OIDN_NAMESPACE_BEGIN
   void RTLightmapFilter::unsetImage(const std::string& name)
   {
     if (name == "color")
+    {
       removeParam(color);
+      autoexposureCached = false;
+    }
     else if (name == "output")
       removeParam(output);
+    else if (name == "coverage")
+      removeParam(coverage);
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -3,9 +3,27 @@
 
 #include "subdevice.h"
 #include "engine.h"
+#include "tza.h"
+#include <cstdio>
+#include <iomanip>
+#include <random>
 
 OIDN_NAMESPACE_BEGIN
 
+  // Renames a file, replacing the destination file if it exists
+  static bool replaceFile(const std::string& srcFilename, const std::string& dstFilename)
+  {
+  #if defined(_WIN32)
+    // std::rename fails on Windows if the destination exists. The paths are interpreted in the
+    // same code page as in MappedFile, which opens the files with FILE_SHARE_DELETE, so even a
+    // cache file mapped by this or another process can be replaced.
+    return MoveFileExA(srcFilename.c_str(), dstFilename.c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+  #else
+    return std::rename(srcFilename.c_str(), dstFilename.c_str()) == 0;
+  #endif
+  }
+
   Subdevice::Subdevice(std::unique_ptr<Engine>&& engine)
     : engine(std::move(engine))
   {
@@ -25,12 +43,87 @@ OIDN_NAMESPACE_BEGIN
       scratchArenaManager->trim();
   }
 
-  std::shared_ptr<TensorMap> Subdevice::getCachedTensors(const void* key)
+  std::shared_ptr<TensorMap> Subdevice::getCachedTensors(const Data& weights)
+  {
+    CachedTensors& cached = cachedTensors[weights.ptr];
+    if (!cached.tensorMap)
+    {
+      cached.filename = getWeightCacheFilename(weights);
+
+      // Try to map the already reordered weights from the on-disk cache
+      if (!cached.filename.empty())
+      {
+        try
+        {
+          cached.file = makeRef<MappedFile>(cached.filename);
+          cached.tensorMap = parseTZA(cached.file->getPtr(), cached.file->getSize());
+          cached.numSavedTensors = cached.tensorMap->size();
+
+          if (engine->getDevice()->isVerbose(2))
+            std::cout << "Weight cache: " << cached.filename << std::endl;
+        }
+        catch (const std::exception&)
+        {
+          // Missing or invalid cache file, the weights will be reordered and saved again
+          cached.file.reset();
+          cached.tensorMap.reset();
+        }
+      }
+
+      if (!cached.tensorMap)
+        cached.tensorMap = std::make_shared<TensorMap>();
+    }
+
+    return cached.tensorMap;
+  }
+
+  void Subdevice::saveCachedTensors(const Data& weights)
   {
-    std::shared_ptr<TensorMap>& tensorMap = cachedTensors[key];
-    if (!tensorMap)
-      tensorMap = std::make_shared<TensorMap>();
-    return tensorMap;
+    auto cachedIter = cachedTensors.find(weights.ptr);
+    if (cachedIter == cachedTensors.end())
+      return;
+
+    CachedTensors& cached = cachedIter->second;
+    if (cached.filename.empty() || cached.tensorMap->size() <= cached.numSavedTensors)
+      return;
+
+    // Write a temporary file first and then rename it, so other processes never map a partial file
+    const std::string tempFilename = cached.filename + "." + toString(std::random_device()()) + ".tmp";
+    try
+    {
+      writeTZA(tempFilename, *cached.tensorMap);
+      if (!replaceFile(tempFilename, cached.filename))
+        throw std::runtime_error("cannot rename file: '" + tempFilename + "'");
+      cached.numSavedTensors = cached.tensorMap->size();
+    }
+    catch (const std::exception& e)
+    {
+      std::remove(tempFilename.c_str());
+      engine->getDevice()->printWarning(std::string("could not save weight cache: ") + e.what());
+    }
+  }
+
+  bool Subdevice::isWeightCacheLoaded(const Data& weights) const
+  {
+    auto cachedIter = cachedTensors.find(weights.ptr);
+    return cachedIter != cachedTensors.end() && cachedIter->second.file;
+  }
+
+  std::string Subdevice::getWeightCacheFilename(const Data& weights) const
+  {
+    // The tensors must be usable directly from host memory
+    Device* device = engine->getDevice();
+    if (device->getWeightCacheDir().empty() || device->needWeightAndBiasOnDevice())
+      return "";
+
+    // The cache is keyed by the hash of the original weights and the final layout and data types
+    std::stringstream sm;
+    sm << device->getWeightCacheDir() << "/oidn_weights_"
+       << std::hex << std::setw(16) << std::setfill('0') << weights.getHash() << std::dec << "_"
+       << device->getWeightLayout() << "_"
+       << device->getWeightDataType() << "_"
+       << device->getTensorDataType() << ".tza";
+    return sm.str();
   }
 
 OIDN_NAMESPACE_END
\ No newline at end of file
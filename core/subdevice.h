@@ -6,6 +6,7 @@
 #include "device.h"
 #include "arena.h"
 #include "tensor.h"
+#include "mapped_file.h"
 
 OIDN_NAMESPACE_BEGIN
 
@@ -21,8 +22,10 @@ OIDN_NAMESPACE_BEGIN
     Ref<Arena> newScratchArena(size_t byteSize, const std::string& name = "");
     void trimScratch();
 
-    // Tensor cache
-    std::shared_ptr<TensorMap> getCachedTensors(const void* key);
+    // Tensor cache for the reordered built-in weights, optionally backed by an on-disk cache
+    std::shared_ptr<TensorMap> getCachedTensors(const Data& weights);
+    void saveCachedTensors(const Data& weights);
+    bool isWeightCacheLoaded(const Data& weights) const; // mapped from the on-disk cache?
 
   private:
     // Disable copying
@@ -31,9 +34,19 @@ OIDN_NAMESPACE_BEGIN
 
     std::unique_ptr<Engine> engine; // must be declared first / destroyed last
 
+    struct CachedTensors
+    {
+      std::shared_ptr<TensorMap> tensorMap;
+      std::string filename;       // on-disk cache file
+      Ref<MappedFile> file;       // mapped on-disk cache file referenced by the tensors
+      size_t numSavedTensors = 0; // number of tensors stored in the on-disk cache
+    };
+
+    std::string getWeightCacheFilename(const Data& weights) const;
+
     // Resources
     std::unique_ptr<ScratchArenaManager> scratchArenaManager;
-    std::unordered_map<const void*, std::shared_ptr<TensorMap>> cachedTensors; // cached weights
+    std::unordered_map<const void*, CachedTensors> cachedTensors; // cached weights
   };
 
 OIDN_NAMESPACE_END
\ No newline at end of file
@@ -55,7 +55,23 @@ OIDN_NAMESPACE_BEGIN
       tryReorderWeight<half, float, TensorLayout::oihw, TensorLayout::IOhw8i8o>    (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
       tryReorderWeight<half, float, TensorLayout::oihw, TensorLayout::IOhw16i16o>  (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
       tryReorderWeight<half, half,  TensorLayout::oihw, TensorLayout::ohwi>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
-      tryReorderWeight<half, float, TensorLayout::oihw, TensorLayout::ohwi>        (src, srcBeginI, srcI, dst, dstBeginI, dstI);
+      tryReorderWeight<half, float, TensorLayout::oihw, TensorLayout::ohwi>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      // Dequantized weights
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::oihw>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::oihw>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::OIhw8i8o>    (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::OIhw8i8o>    (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::OIhw16i16o>  (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::OIhw16i16o>  (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::OIhw2o8i8o2i>(src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::OIhw8i16o2i> (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::IOhw8i8o>    (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::IOhw16i16o>  (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, half,  TensorLayout::oihw, TensorLayout::ohwi>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<float, float, TensorLayout::oihw, TensorLayout::ohwi>        (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      // Quantized weights used as is
+      tryReorderWeight<int8_t, int8_t, TensorLayout::oihw, TensorLayout::IOhw8i8o>  (src, srcBeginI, srcI, dst, dstBeginI, dstI) ||
+      tryReorderWeight<int8_t, int8_t, TensorLayout::oihw, TensorLayout::IOhw16i16o>(src, srcBeginI, srcI, dst, dstBeginI, dstI);
 
     if (!ok)
       throw std::logic_error("unsupported weight layout or data type");
@@ -66,6 +82,171 @@ OIDN_NAMESPACE_BEGIN
     reorderWeight(src, 0, src.getI(), dst, 0, dst.getPaddedI());
   }
 
+  template<TensorLayout layout>
+  bool tryTransformWinogradWeight(Tensor& src, Tensor& dst)
+  {
+    if (src.getDataType() != DataType::Float32 || src.getLayout() != layout ||
+        dst.getDataType() != DataType::Float32 || dst.getLayout() != layout)
+      return false;
+
+    // Weight transform matrices (G) of F(2x2, 3x3) and F(4x4, 3x3)
+    static const double G2[4][3] =
+    {
+      {  1.,   0.,  0.},
+      { .5,   .5,  .5 },
+      { .5,  -.5,  .5 },
+      {  0.,   0.,  1.}
+    };
+
+    static const double G4[6][3] =
+    {
+      { 1./4.,   0.,      0.    },
+      {-1./6.,  -1./6.,  -1./6. },
+      {-1./6.,   1./6.,  -1./6. },
+      { 1./24.,  1./12.,  1./6. },
+      { 1./24., -1./12.,  1./6. },
+      { 0.,      0.,      1.    }
+    };
+
+    const int A = dst.getH();
+    const double (*G)[3] = (A == 4) ? G2 : G4;
+
+    TensorAccessor4D<float, layout> srcAcc = src;
+    TensorAccessor4D<float, layout> dstAcc = dst;
+
+    for (int o = 0; o < dstAcc.O; ++o)
+    {
+      for (int i = 0; i < dstAcc.I; ++i)
+      {
+        // U = G g G^T
+        double Gg[6][3];
+        for (int a = 0; a < A; ++a)
+        {
+          for (int w = 0; w < 3; ++w)
+          {
+            Gg[a][w] = 0;
+            for (int h = 0; h < 3; ++h)
+              Gg[a][w] += G[a][h] * srcAcc(o, i, h, w);
+          }
+        }
+
+        for (int a = 0; a < A; ++a)
+        {
+          for (int b = 0; b < A; ++b)
+          {
+            double value = 0;
+            for (int w = 0; w < 3; ++w)
+              value += Gg[a][w] * G[b][w];
+            dstAcc(o, i, a, b) = float(value);
+          }
+        }
+      }
+    }
+
+    return true;
+  }
+
+  void transformWinogradWeight(Tensor& src, Tensor& dst)
+  {
+    if (src.getH() != 3 || src.getW() != 3 ||
+        (dst.getH() != 4 && dst.getH() != 6) || dst.getW() != dst.getH() ||
+        src.getPaddedO() != dst.getPaddedO() || src.getPaddedI() != dst.getPaddedI())
+      throw std::logic_error("unsupported Winograd weight shape");
+
+    bool ok =
+      tryTransformWinogradWeight<TensorLayout::IOhw8i8o>  (src, dst) ||
+      tryTransformWinogradWeight<TensorLayout::IOhw16i16o>(src, dst);
+
+    if (!ok)
+      throw std::logic_error("unsupported Winograd weight layout or data type");
+  }
+
+  template<typename ScaleT>
+  bool tryDequantizeWeight(Tensor& src, Tensor& scale, Tensor& dst)
+  {
+    if (scale.getDataType() != DataTypeOf<ScaleT>::value)
+      return false;
+
+    TensorAccessor4D<int8_t, TensorLayout::oihw> srcAcc = src;
+    TensorAccessor1D<ScaleT> scaleAcc = scale;
+    TensorAccessor4D<float, TensorLayout::oihw> dstAcc = dst;
+
+    for (int o = 0; o < dstAcc.O; ++o)
+    {
+      const float oScale = scaleAcc(o);
+      for (int i = 0; i < dstAcc.I; ++i)
+        for (int h = 0; h < dstAcc.H; ++h)
+          for (int w = 0; w < dstAcc.W; ++w)
+            dstAcc(o, i, h, w) = float(srcAcc(o, i, h, w)) * oScale;
+    }
+
+    return true;
+  }
+
+  void dequantizeWeight(Tensor& src, Tensor& scale, Tensor& dst)
+  {
+    if (src.getDataType() != DataType::Int8 || src.getLayout() != TensorLayout::oihw ||
+        dst.getDataType() != DataType::Float32 || dst.getLayout() != TensorLayout::oihw ||
+        src.getDims() != dst.getDims() ||
+        scale.getRank() != 1 || scale.getLayout() != TensorLayout::x || scale.getX() != src.getO())
+      throw std::invalid_argument("invalid quantized weights");
+
+    bool ok =
+      tryDequantizeWeight<half> (src, scale, dst) ||
+      tryDequantizeWeight<float>(src, scale, dst);
+
+    if (!ok)
+      throw std::invalid_argument("invalid quantized weight scale data type");
+  }
+
+  template<TensorLayout layout>
+  bool tryQuantizeWeight(Tensor& src, Tensor& dst, Tensor& scale)
+  {
+    if (src.getDataType() != DataType::Float32 || src.getLayout() != layout ||
+        dst.getDataType() != DataType::Int8    || dst.getLayout() != layout)
+      return false;
+
+    TensorAccessor4D<float, layout> srcAcc = src;
+    TensorAccessor4D<int8_t, layout> dstAcc = dst;
+    TensorAccessor1D<float> scaleAcc = scale;
+
+    for (int o = 0; o < dstAcc.O; ++o)
+    {
+      // Symmetric quantization with the maximum absolute value of the output channel
+      float maxAbs = 0;
+      for (int i = 0; i < dstAcc.I; ++i)
+        for (int h = 0; h < dstAcc.H; ++h)
+          for (int w = 0; w < dstAcc.W; ++w)
+            maxAbs = max(maxAbs, std::abs(srcAcc(o, i, h, w)));
+
+      const float oScale = maxAbs > 0 ? maxAbs / 127.f : 1.f;
+      scaleAcc(o) = oScale;
+
+      for (int i = 0; i < dstAcc.I; ++i)
+        for (int h = 0; h < dstAcc.H; ++h)
+          for (int w = 0; w < dstAcc.W; ++w)
+            dstAcc(o, i, h, w) = int8_t(clamp(std::round(srcAcc(o, i, h, w) / oScale), -127.f, 127.f));
+    }
+
+    return true;
+  }
+
+  void quantizeWeight(Tensor& src, Tensor& dst, Tensor& scale)
+  {
+    if (src.getPaddedO() != dst.getPaddedO() || src.getPaddedI() != dst.getPaddedI() ||
+        src.getH() != dst.getH() || src.getW() != dst.getW() ||
+        scale.getDataType() != DataType::Float32 || scale.getLayout() != TensorLayout::x ||
+        scale.getPaddedX() != dst.getPaddedO())
+      throw std::logic_error("unsupported weight quantization shape");
+
+    bool ok =
+      tryQuantizeWeight<TensorLayout::IOhw8i8o>  (src, dst, scale) ||
+      tryQuantizeWeight<TensorLayout::IOhw16i16o>(src, dst, scale);
+
+    if (!ok)
+      throw std::logic_error("unsupported weight layout or data type for quantization");
+  }
+
   template<typename SrcT, typename DstT>
   bool tryReorderBias(Tensor& src, Tensor& dst)
   {
@@ -97,4 +278,15 @@ OIDN_NAMESPACE_BEGIN
       throw std::logic_error("unsupported bias layout or data type");
   }
 
+  void reorderWeightScale(Tensor& src, Tensor& dst)
+  {
+    // The scales of the padding output channels are zero just like their weights
+    bool ok = src.getLayout() == TensorLayout::x && dst.getLayout() == TensorLayout::x &&
+      (tryReorderBias<half,  float>(src, dst) ||
+       tryReorderBias<float, float>(src, dst));
+
+    if (!ok)
+      throw std::logic_error("unsupported weight scale layout or data type");
+  }
+
 OIDN_NAMESPACE_END
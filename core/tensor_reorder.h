@@ -7,6 +7,10 @@ OIDN_NAMESPACE_BEGIN
 
   void reorderWeight(Tensor& src, int srcBeginI, int srcI, Tensor& dst, int dstBeginI, int dstI);
   void reorderWeight(Tensor& src, Tensor& dst);
+  void transformWinogradWeight(Tensor& src, Tensor& dst);
+  void dequantizeWeight(Tensor& src, Tensor& scale, Tensor& dst);
+  void quantizeWeight(Tensor& src, Tensor& dst, Tensor& scale);
   void reorderBias(Tensor& src, Tensor& dst);
+  void reorderWeightScale(Tensor& src, Tensor& dst);
 
 OIDN_NAMESPACE_END
@@ -8,6 +8,8 @@
 #if defined(__linux__)
   #include <sched.h>
   #include <unordered_set>
+  #include <unordered_map>
+  #include <algorithm>
 #elif defined(__APPLE__)
   #include <mach/thread_act.h>
   #include <mach/mach_init.h>
@@ -24,7 +26,7 @@ OIDN_NAMESPACE_BEGIN
   // ThreadAffinity: Windows
   // -----------------------------------------------------------------------------------------------
 
-  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose)
+  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose, bool groupByNumaNode)
     : Verbose(verbose)
   {
     HMODULE hLib = GetModuleHandle(TEXT("kernel32"));
@@ -131,7 +133,7 @@ OIDN_NAMESPACE_BEGIN
   // ThreadAffinity: Linux
   // -----------------------------------------------------------------------------------------------
 
-  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose)
+  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose, bool groupByNumaNode)
     : Verbose(verbose)
   {
     // Get the process affinity mask
@@ -168,6 +170,30 @@ OIDN_NAMESPACE_BEGIN
       }
     }
 
+    // Parse the NUMA topology
+    std::unordered_map<int, int> cpuNumaNodes;
+    for (int nodeID : parseList("/sys/devices/system/node/online"))
+    {
+      for (int cpuID : parseList("/sys/devices/system/node/node" + std::to_string(nodeID) + "/cpulist"))
+        cpuNumaNodes[cpuID] = nodeID;
+    }
+
+    auto getCPUNumaNode = [&](int cpuID)
+    {
+      auto nodeIter = cpuNumaNodes.find(cpuID);
+      return (nodeIter != cpuNumaNodes.end()) ? nodeIter->second : 0;
+    };
+
+    // Group the threads by NUMA node if requested, keeping the core order within the nodes
+    // Otherwise the core order is kept, which determines the cores used by fewer threads
+    if (groupByNumaNode)
+    {
+      std::stable_sort(threadIDs.begin(), threadIDs.end(), [&](int a, int b)
+      {
+        return getCPUNumaNode(a) < getCPUNumaNode(b);
+      });
+    }
+
   #if 0
     for (size_t i = 0; i < thread_ids.size(); ++i)
       std::cout << "thread " << i << " -> " << thread_ids[i] << std::endl;
@@ -176,6 +202,7 @@ OIDN_NAMESPACE_BEGIN
     // Create the affinity structures
     affinities.resize(threadIDs.size());
     oldAffinities.resize(threadIDs.size());
+    numaNodes.resize(threadIDs.size());
 
     for (size_t i = 0; i < threadIDs.size(); ++i)
     {
@@ -185,6 +212,7 @@ OIDN_NAMESPACE_BEGIN
 
       affinities[i] = affinity;
       oldAffinities[i] = affinity;
+      numaNodes[i] = getCPUNumaNode(threadIDs[i]);
     }
   }
 
@@ -257,7 +285,7 @@ OIDN_NAMESPACE_BEGIN
   // ThreadAffinity: macOS
   // -----------------------------------------------------------------------------------------------
 
-  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose)
+  ThreadAffinity::ThreadAffinity(int maxNumThreadsPerCore, int verbose, bool groupByNumaNode)
     : Verbose(verbose)
   {
     // Query the thread/CPU topology
@@ -106,7 +106,7 @@ OIDN_NAMESPACE_BEGIN
   class ThreadAffinity : public Verbose
   {
   public:
-    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0);
+    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0, bool groupByNumaNode = false);
 
     int getNumThreads() const
     {
@@ -119,6 +119,9 @@ OIDN_NAMESPACE_BEGIN
     // Restores the affinity of the thread
     void restore(int threadIndex);
 
+    // Returns the NUMA node of the thread (0 if unknown)
+    int getNumaNode(int threadIndex) const { return 0; }
+
   private:
     typedef BOOL (WINAPI *GetLogicalProcessorInformationExFunc)(LOGICAL_PROCESSOR_RELATIONSHIP,
                                                                 PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX,
@@ -144,7 +147,7 @@ OIDN_NAMESPACE_BEGIN
   class ThreadAffinity : public Verbose
   {
   public:
-    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0);
+    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0, bool groupByNumaNode = false);
 
     int getNumThreads() const
     {
@@ -157,12 +160,20 @@ OIDN_NAMESPACE_BEGIN
     // Restores the affinity of the thread
     void restore(int threadIndex);
 
+    // Returns the NUMA node of the thread (0 if unknown), the threads are grouped by node only if
+    // requested, otherwise they are in core order
+    int getNumaNode(int threadIndex) const
+    {
+      return numaNodes[threadIndex];
+    }
+
   private:
     // Parses a list of numbers from a file in /sys/devices/system
     static std::vector<int> parseList(const std::string& filename);
 
     std::vector<cpu_set_t> affinities;    // thread affinities
     std::vector<cpu_set_t> oldAffinities; // original thread affinities
+    std::vector<int> numaNodes;           // NUMA nodes of the threads
   };
 
 #elif defined(__APPLE__)
@@ -174,7 +185,7 @@ OIDN_NAMESPACE_BEGIN
   class ThreadAffinity : public Verbose
   {
   public:
-    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0);
+    ThreadAffinity(int maxNumThreadsPerCore = INT_MAX, int verbose = 0, bool groupByNumaNode = false);
 
     int getNumThreads() const
     {
@@ -187,6 +198,9 @@ OIDN_NAMESPACE_BEGIN
     // Restores the affinity of the thread
     void restore(int threadIndex);
 
+    // Returns the NUMA node of the thread (0 if unknown)
+    int getNumaNode(int threadIndex) const { return 0; }
+
   private:
     std::vector<thread_affinity_policy> affinities;    // thread affinities
     std::vector<thread_affinity_policy> oldAffinities; // original thread affinities
@@ -3,6 +3,7 @@
 
 #include "tza.h"
 #include "exception.h"
+#include <fstream>
 
 OIDN_NAMESPACE_BEGIN
 
@@ -13,6 +14,24 @@ OIDN_NAMESPACE_BEGIN
       throw Exception(Error::InvalidOperation, "invalid or corrupted weights blob");
   }
 
+  // Tensor layouts supported by the archive, stored by name
+  static const TensorLayout tzaTensorLayouts[] =
+  {
+    TensorLayout::x,
+    TensorLayout::chw,
+    TensorLayout::Chw8c,
+    TensorLayout::Chw16c,
+    TensorLayout::oihw,
+    TensorLayout::OIhw8i8o,
+    TensorLayout::OIhw16i16o,
+    TensorLayout::OIhw2o8i8o2i,
+    TensorLayout::OIhw8i16o2i,
+    TensorLayout::IOhw8i8o,
+    TensorLayout::IOhw16i16o,
+    TensorLayout::hwc,
+    TensorLayout::ohwi,
+  };
+
   // Reads a value from a buffer (with bounds checking) and advances the pointer
   template<typename T>
   oidn_inline T read(const char*& ptr, const char* end)
@@ -24,6 +43,13 @@ OIDN_NAMESPACE_BEGIN
     return value;
   }
 
+  // Writes a value to a stream
+  template<typename T>
+  oidn_inline void write(std::ostream& sm, const T& value)
+  {
+    sm.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
   std::shared_ptr<TensorMap> parseTZA(const void* buffer, size_t size)
   {
     const char* input = static_cast<const char*>(buffer);
@@ -37,10 +63,12 @@ OIDN_NAMESPACE_BEGIN
     // Parse the version
     const int majorVersion = read<uint8_t>(input, bufferEnd);
     const int minorVersion = read<uint8_t>(input, bufferEnd);
-    UNUSED(minorVersion);
-    if (majorVersion != 2)
+    if (majorVersion != 2 || minorVersion > 1)
       throw Exception(Error::InvalidOperation, "unsupported weights blob version");
 
+    // Version 2.1 adds padded dimensions and arbitrary (e.g. blocked) layouts
+    const bool hasPaddedDims = minorVersion >= 1;
+
     // Parse the table offset and jump to the table
     const uint64_t tableOffset = read<uint64_t>(input, bufferEnd);
     input = static_cast<const char*>(buffer) + tableOffset;
@@ -67,18 +95,35 @@ OIDN_NAMESPACE_BEGIN
       tensorDesc.dims.resize(ndims);
       for (int j = 0; j < ndims; ++j)
         tensorDesc.dims[j] = read<uint32_t>(input, bufferEnd);
-      tensorDesc.paddedDims = tensorDesc.dims;
+
+      // Parse the padded shape of the tensor
+      tensorDesc.paddedDims.resize(ndims);
+      for (int j = 0; j < ndims; ++j)
+      {
+        tensorDesc.paddedDims[j] = hasPaddedDims ? read<uint32_t>(input, bufferEnd) : tensorDesc.dims[j];
+        if (tensorDesc.paddedDims[j] < tensorDesc.dims[j])
+          throw Exception(Error::InvalidOperation, "invalid tensor padded dimensions");
+      }
 
       // Parse the layout of the tensor
-      checkBounds(input, bufferEnd, ndims);
-      std::string layout = std::string(input, input + ndims);
-      if (layout == "x")
-        tensorDesc.layout = TensorLayout::x;
-      else if (layout == "oihw")
-        tensorDesc.layout = TensorLayout::oihw;
-      else
+      const size_t layoutLen = hasPaddedDims ? read<uint8_t>(input, bufferEnd) : ndims;
+      checkBounds(input, bufferEnd, layoutLen);
+      const std::string layout(input, input + layoutLen);
+      input += layoutLen;
+
+      bool layoutFound = false;
+      for (TensorLayout tzaLayout : tzaTensorLayouts)
+      {
+        if (layout == toString(tzaLayout))
+        {
+          tensorDesc.layout = tzaLayout;
+          layoutFound = true;
+          break;
+        }
+      }
+
+      if (!layoutFound || (!hasPaddedDims && layout != "x" && layout != "oihw"))
         throw Exception(Error::InvalidOperation, "invalid tensor layout");
-      input += ndims;
 
       // Parse the data type of the tensor
       const char dataType = read<char>(input, bufferEnd);
@@ -86,6 +131,8 @@ OIDN_NAMESPACE_BEGIN
         tensorDesc.dataType = DataType::Float32;
       else if (dataType == 'h')
         tensorDesc.dataType = DataType::Float16;
+      else if (dataType == 'b')
+        tensorDesc.dataType = DataType::Int8;
       else
         throw Exception(Error::InvalidOperation, "invalid tensor data type");
 
@@ -102,4 +149,71 @@ OIDN_NAMESPACE_BEGIN
     return tensorMap;
   }
 
+  void writeTZA(const std::string& filename, const TensorMap& tensorMap)
+  {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file)
+      throw std::runtime_error("cannot open file: '" + filename + "'");
+
+    // Write the header, the table offset is updated at the end
+    write(file, uint16_t(0x41D7));
+    write(file, uint8_t(2));
+    write(file, uint8_t(1));
+    write(file, uint64_t(0));
+
+    // Write the tensor data, aligned so that the tensors can be used directly from a mapped file
+    constexpr size_t dataAlignment = 64;
+    std::vector<uint64_t> tensorOffsets;
+    for (const auto& item : tensorMap)
+    {
+      const Ref<Tensor>& tensor = item.second;
+      const uint64_t offset = round_up(uint64_t(file.tellp()), uint64_t(dataAlignment));
+      const char zeros[dataAlignment] = {};
+      file.write(zeros, offset - uint64_t(file.tellp()));
+      file.write(static_cast<const char*>(tensor->getPtr()), tensor->getByteSize());
+      tensorOffsets.push_back(offset);
+    }
+
+    // Write the table
+    const uint64_t tableOffset = file.tellp();
+    write(file, uint32_t(tensorMap.size()));
+    size_t i = 0;
+    for (const auto& item : tensorMap)
+    {
+      const std::string& name = item.first;
+      const TensorDesc& desc = item.second->getDesc();
+
+      write(file, uint16_t(name.size()));
+      file.write(name.data(), name.size());
+
+      write(file, uint8_t(desc.getRank()));
+      for (int dim : desc.dims)
+        write(file, uint32_t(dim));
+      for (int dim : desc.paddedDims)
+        write(file, uint32_t(dim));
+
+      const std::string layout = toString(desc.layout);
+      write(file, uint8_t(layout.size()));
+      file.write(layout.data(), layout.size());
+
+      if (desc.dataType == DataType::Float32)
+        write(file, 'f');
+      else if (desc.dataType == DataType::Float16)
+        write(file, 'h');
+      else if (desc.dataType == DataType::Int8)
+        write(file, 'b');
+      else
+        throw std::invalid_argument("unsupported tensor data type");
+
+      write(file, tensorOffsets[i++]);
+    }
+
+    // Update the table offset in the header
+    file.seekp(4);
+    write(file, tableOffset);
+
+    if (!file)
+      throw std::runtime_error("cannot write file: '" + filename + "'");
+  }
+
 OIDN_NAMESPACE_END
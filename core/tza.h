@@ -8,6 +8,10 @@
 OIDN_NAMESPACE_BEGIN
 
   // Parses tensors from a Tensor Archive (TZA)
+  // The tensors point directly into the buffer, which must remain valid while they are used
   std::shared_ptr<TensorMap> parseTZA(const void* buffer, size_t size);
 
-OIDN_NAMESPACE_END
\ No newline at end of file
+  // Writes host tensors with arbitrary layouts to a Tensor Archive (TZA) file
+  void writeTZA(const std::string& filename, const TensorMap& tensorMap);
+
+OIDN_NAMESPACE_END
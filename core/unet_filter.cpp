@@ -3,6 +3,9 @@
 
 #include "unet_filter.h"
 #include "tza.h"
+#include "common/timer.h"
+#include <sstream>
+#include <cstring>
 
 OIDN_NAMESPACE_BEGIN
 
@@ -14,6 +17,12 @@ OIDN_NAMESPACE_BEGIN
   {
     if (name == "weights")
       setParam(userWeightsBlob, data);
+    else if (name == "dirtyRects")
+    {
+      if (data.size % (4 * sizeof(int)) != 0)
+        throw Exception(Error::InvalidArgument, "invalid dirty rectangles data size");
+      dirtyRects = data; // read at execution, so changing the rectangles does not need reinitialization
+    }
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -24,6 +33,8 @@ OIDN_NAMESPACE_BEGIN
   {
     if (name == "weights")
       dirtyParam |= userWeightsBlob;
+    else if (name == "dirtyRects")
+      ; // nothing to do
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -34,6 +45,8 @@ OIDN_NAMESPACE_BEGIN
   {
     if (name == "weights")
       removeParam(userWeightsBlob);
+    else if (name == "dirtyRects")
+      dirtyRects = nullptr;
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -48,12 +61,38 @@ OIDN_NAMESPACE_BEGIN
       if (qualityValue == Quality::Default)
         qualityValue = defaultQuality;
       else if (qualityValue != Quality::High && qualityValue != Quality::Balanced &&
-               qualityValue != Quality::Fast)
+               qualityValue != Quality::Fast && qualityValue != Quality::Preview)
         throw Exception(Error::InvalidArgument, "unknown filter quality mode");
       setParam(quality, qualityValue);
     }
     else if (name == "maxMemoryMB")
       setParam(maxMemoryMB, value);
+    else if (name == "batchSize")
+    {
+      if (value < 1)
+        throw Exception(Error::InvalidArgument, "invalid batch size");
+      setParam(batchSize, value);
+    }
+    else if (name == "autotune")
+      setParam(autotune, value);
+    else if (name == "cacheAutoexposure")
+      setParam(cacheAutoexposure, value);
+    else if (name == "temporalAutoexposure")
+    {
+      // Changing the mode does not need reinitialization, but the previous input scales are discarded
+      temporalAutoexposure = value;
+      temporalAutoexposureState.reset();
+    }
+    else if (name == "roiX")
+      roiX = value;
+    else if (name == "roiY")
+      roiY = value;
+    else if (name == "roiWidth" || name == "roiHeight")
+    {
+      if (value < 0)
+        throw Exception(Error::InvalidArgument, "invalid region of interest size");
+      (name == "roiWidth" ? roiWidth : roiHeight) = value;
+    }
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -66,6 +105,22 @@ OIDN_NAMESPACE_BEGIN
       return static_cast<int>(quality);
     else if (name == "maxMemoryMB")
       return maxMemoryMB;
+    else if (name == "batchSize")
+      return batchSize;
+    else if (name == "autotune")
+      return autotune;
+    else if (name == "cacheAutoexposure")
+      return cacheAutoexposure;
+    else if (name == "temporalAutoexposure")
+      return temporalAutoexposure;
+    else if (name == "roiX")
+      return roiX;
+    else if (name == "roiY")
+      return roiY;
+    else if (name == "roiWidth")
+      return roiWidth;
+    else if (name == "roiHeight")
+      return roiHeight;
     else if (name == "tileAlignment")
       return tileAlignment;
     else if (name == "alignment")
@@ -75,6 +130,14 @@ OIDN_NAMESPACE_BEGIN
     }
     else if (name == "tileOverlap")
       return tileOverlap;
+    else if (name == "tileWidth")
+      return tileW;
+    else if (name == "tileHeight")
+      return tileH;
+    else if (name == "pipelined")
+      return pipelined;
+    else if (name == "cachedWeights")
+      return weightCacheLoaded;
     else if (name == "overlap")
     {
       device->printWarning("filter parameter 'overlap' is deprecated, use 'tileOverlap' instead");
@@ -93,6 +156,12 @@ OIDN_NAMESPACE_BEGIN
       device->printWarning("filter parameter 'hdrScale' is deprecated, use 'inputScale' instead");
       inputScale = value;
     }
+    else if (name == "autoexposureSmoothing")
+    {
+      if (!(value >= 0.f && value < 1.f))
+        throw Exception(Error::InvalidArgument, "invalid autoexposure smoothing factor");
+      autoexposureSmoothing = value;
+    }
     else
       device->printWarning("unknown filter parameter or type mismatch: '" + name + "'");
 
@@ -108,6 +177,8 @@ OIDN_NAMESPACE_BEGIN
       device->printWarning("filter parameter 'hdrScale' is deprecated, use 'inputScale' instead");
       return inputScale;
     }
+    else if (name == "autoexposureSmoothing")
+      return autoexposureSmoothing;
     else
       throw Exception(Error::InvalidArgument, "unknown filter parameter or type mismatch: '" + name + "'");
   }
@@ -122,7 +193,20 @@ OIDN_NAMESPACE_BEGIN
                       ((color  && output->overlaps(*color))  ||
                        (albedo && output->overlaps(*albedo)) ||
                        (normal && output->overlaps(*normal)));
-    setParam(inplace, inplaceNew);
+
+    if (inplaceNew != inplace)
+    {
+      // Only tiled in-place filtering needs a different model (with a temporary output image), so
+      // rebinding the images of a single-tile filter does not require reinitialization
+      if (instances.empty() || batchSize * tileCountH * tileCountW > 1)
+        dirtyParam = true;
+      inplace = inplaceNew;
+    }
+
+    // Setting or removing the dirty rectangles of a single-tile in-place filter changes whether a
+    // temporary output image is needed
+    if (!instances.empty() && bool(outputTemp) != needsOutputTemp())
+      dirtyParam = true;
 
     if (dirtyParam)
     {
@@ -137,6 +221,11 @@ OIDN_NAMESPACE_BEGIN
         device->trimScratch();
       prevMaxMemoryMB = maxMemoryMB;
     }
+    else if (streaming && hdr && math::isnan(inputScale))
+    {
+      // Changing inputScale does not reinitialize the filter, so the parameters are not rechecked
+      throw Exception(Error::InvalidOperation, "inputScale must be set when streaming HDR images");
+    }
 
     dirty = false;
     dirtyParam = false;
@@ -150,63 +239,283 @@ OIDN_NAMESPACE_BEGIN
     if (H <= 0 || W <= 0)
       return;
 
+    if (streaming)
+    {
+      if ((roiWidth > 0 && roiHeight > 0) || dirtyRects)
+        throw Exception(Error::InvalidOperation, "region of interest is not supported for streamed images");
+      executeStreaming();
+      return;
+    }
+
+    // Get the regions of the output to denoise, which may be tiled differently than the full image
+    const std::vector<Region> regions = getRegions();
+    if (regions.empty())
+      return;
+
+    // Find the covered blocks of the images for skipping the empty tiles
+    if (coverage && coverageDirty)
+    {
+      updateCoverageBlocks();
+      coverageDirty = false;
+    }
+
+    // The temporary output of in-place filtering is copied tile by tile if not all tiles are denoised
+    const bool copyTiles = !isFullRegion(regions) || coverage;
+
+    // Compute the input scale of each image in the batch, unless the cached autoexposure results
+    // can be reused because the color image has not been set since they were computed
+    const bool useAutoexposure = hdr && math::isnan(inputScale);
+    const bool cachedAutoexposure = useAutoexposure && autoexposureCached;
+
     device->execute([&]()
     {
       // Initialize the progress state
       Ref<Progress> progress;
       if (progressFunc)
       {
+        int numTiles = 0;
+        for (int b = 0; b < batchSize; ++b)
+          forEachTile(regions, b, [&](const TileDesc&) { numTiles++; });
+
         size_t workAmount = 0;
-        for (int i = 0; i < device->getNumSubdevices(); ++i)
-          workAmount += instances[i].graph->getWorkAmount();
-        workAmount *= (tileCountH * tileCountW) / device->getNumSubdevices();
-        if (hdr && math::isnan(inputScale))
-          workAmount += autoexposure->getWorkAmount();
+        for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+          workAmount += instances[tileIndex % instances.size()].graph->getWorkAmount();
+        if (useAutoexposure && !cachedAutoexposure)
+          workAmount += autoexposure->getWorkAmount() * batchSize;
         if (outputTemp)
-          workAmount += imageCopy->getWorkAmount();
+          workAmount += imageCopy->getWorkAmount() * (copyTiles ? numTiles : 1);
 
         progress = makeRef<Progress>(progressFunc, progressUserPtr, workAmount);
       }
 
-      // Set the input scale
-      if (math::isnan(inputScale))
+      if (profiler)
+        profiler->reset();
+
+      // With temporal autoexposure the smoothed input scales of the last completed execution are
+      // used if available, so the tiles do not depend on the autoexposure of the current images,
+      // whose results are used only by the next execution
+      std::vector<float> temporalScales;
+      if (useAutoexposure && temporalAutoexposure)
       {
-        if (hdr)
-        {
-          autoexposure->setSrc(color);
-          autoexposure->submit(progress);
+        if (!temporalAutoexposureState || int(temporalAutoexposureState->scales.size()) != batchSize)
+          temporalAutoexposureState = std::make_shared<TemporalAutoexposureState>(batchSize);
+
+        std::lock_guard<std::mutex> lock(temporalAutoexposureState->mutex);
+        bool valid = true;
+        for (float scale : temporalAutoexposureState->scales)
+          valid &= !math::isnan(scale);
+        if (valid)
+          temporalScales = temporalAutoexposureState->scales;
+      }
+      const bool deferAutoexposure = !temporalScales.empty();
+
+      // The deferred autoexposure is submitted after the tiles, unless the output is written
+      // directly to the input images
+      const bool lateAutoexposure = deferAutoexposure && !(inplace && !outputTemp);
+
+      if (useAutoexposure && !lateAutoexposure && !cachedAutoexposure)
+      {
+        submitAutoexposure(progress);
+        if (!deferAutoexposure)
           device->submitBarrier();
-          transferFunc->setInputScale(autoexposure->getDstPtr());
+      }
+
+      // Iterate over the images in the batch and their tiles
+      auto submitTiles = [&]()
+      {
+        int tileIndex = 0;
+        pipelinedGraph.reset();
+
+        for (int b = 0; b < batchSize; ++b)
+        {
+          auto colorB  = getBatchImage(color, b);
+          auto albedoB = getBatchImage(albedo, b);
+          auto normalB = getBatchImage(normal, b);
+          auto outputB = getBatchImage(outputTemp ? outputTemp : output, b);
+
+          forEachTile(regions, b, [&](const TileDesc& tile)
+          {
+            const int instanceID = tileIndex % int(instances.size());
+            auto& instance = instances[instanceID];
+
+            // Set the input scale, input and output of the image for the instance only, as the
+            // previous tile in the pipeline may belong to the previous image in the batch
+            if (deferAutoexposure)
+              instance.transferFunc->setInputScale(temporalScales[b]);
+            else if (useAutoexposure)
+              instance.transferFunc->setInputScale(autoexposureDsts[b]->getPtr());
+            else
+              instance.transferFunc->setInputScale(math::isnan(inputScale) ? 1.f : inputScale);
+
+            if (prefilterAux)
+            {
+              // The main input is set by setAuxTile
+              instance.albedoInputProcess->setSrc(nullptr, albedoB, nullptr);
+              instance.normalInputProcess->setSrc(nullptr, nullptr, normalB);
+            }
+            else
+              instance.inputProcess->setSrc(colorB, albedoB, normalB);
+            instance.outputProcess->setDst(outputB);
+
+            // Set the input tile, which is read from the prefiltered auxiliary tiles if enabled
+            if (prefilterAux)
+            {
+              setAuxTile(instanceID, colorB, tile.h, tile.w, tile.H1, tile.W1);
+              instance.inputProcess->setTile(
+                0, 0,
+                tile.alignOffsetH, tile.alignOffsetW,
+                tile.H1, tile.W1);
+            }
+            else
+            {
+              instance.inputProcess->setTile(
+                tile.h, tile.w,
+                tile.alignOffsetH, tile.alignOffsetW,
+                tile.H1, tile.W1);
+            }
+
+            // Set the output tile
+            instance.outputProcess->setTile(
+              tile.alignOffsetH + (tile.outputH - tile.h), tile.alignOffsetW + (tile.outputW - tile.w),
+              tile.outputH, tile.outputW,
+              tile.H2, tile.W2);
+
+            //printf("Tile: %d %d -> %d %d\n", tile.outputW, tile.outputH, tile.outputW+tile.W2, tile.outputH+tile.H2);
+
+            // Denoise the tile
+            if (pipelined)
+              submitPipelinedTile(instance.graph, progress);
+            else
+              instance.graph->submit(progress);
+
+            // Next tile
+            tileIndex++;
+          });
+        }
+
+        // The tiles of consecutive images in the batch are also pipelined
+        if (pipelined)
+          flushPipeline(progress);
+      };
+
+      // Compute the autoexposure of the current images for the next execution
+      auto submitNextAutoexposure = [&]()
+      {
+        if (lateAutoexposure && !cachedAutoexposure)
+          submitAutoexposure(progress);
+        if (useAutoexposure && temporalAutoexposure)
+          submitTemporalAutoexposureUpdate();
+      };
+
+      // The late autoexposure is independent of the tiles, so it is executed concurrently with them
+      // if supported, otherwise after them
+      Engine* engine = device->getEngine();
+      if (lateAutoexposure && !cachedAutoexposure && device->getNumSubdevices() == 1 && !profiler &&
+          engine->isConcurrentSubmitSupported())
+        engine->submitConcurrent({submitTiles, submitNextAutoexposure});
+      else
+      {
+        submitTiles();
+        submitNextAutoexposure();
+      }
+
+      device->submitBarrier();
+
+      // The autoexposure results are valid until the color image is set again, unless it is
+      // overwritten by the output
+      if (useAutoexposure)
+        autoexposureCached = cacheAutoexposure && !inplace;
+
+      // Copy the output image to the final buffer if filtering in-place
+      if (outputTemp)
+      {
+        if (!copyTiles)
+        {
+          imageCopy->setSrc(outputTemp);
+          imageCopy->setDst(output);
+          submitOp(imageCopy, progress);
         }
         else
         {
-          transferFunc->setInputScale(1);
+          // Copy only the denoised tiles, the rest of the temporary output is undefined
+          for (int b = 0; b < batchSize; ++b)
+          {
+            forEachTile(regions, b, [&](const TileDesc& tile)
+            {
+              const size_t h = size_t(b) * H + tile.outputH;
+              imageCopy->setSrc(outputTemp->newSubImage(h, tile.outputW, tile.H2, tile.W2));
+              imageCopy->setDst(output->newSubImage(h, tile.outputW, tile.H2, tile.W2));
+              submitOp(imageCopy, progress);
+            });
+          }
         }
       }
-      else
+    }, sync);
+
+    reportProfile();
+  }
+
+  void UNetFilter::executeStreaming()
+  {
+    // Streaming is always synchronous because the bands are reused
+    device->execute([&]()
+    {
+      Ref<Progress> progress;
+      if (progressFunc)
       {
-        transferFunc->setInputScale(inputScale);
+        size_t workAmount = 0;
+        for (int i = 0; i < device->getNumSubdevices(); ++i)
+          workAmount += instances[i].graph->getWorkAmount();
+        workAmount *= (tileCountH * tileCountW) / device->getNumSubdevices();
+        progress = makeRef<Progress>(progressFunc, progressUserPtr, workAmount);
       }
 
-      // Set the input and output
+      if (profiler)
+        profiler->reset();
+
       for (auto& instance : instances)
       {
-        instance.inputProcess->setSrc(color, albedo, normal);
-        instance.outputProcess->setDst(outputTemp ? outputTemp : output);
+        instance.transferFunc->setInputScale(math::isnan(inputScale) ? 1.f : inputScale);
+        instance.inputProcess->setSrc(colorBand, albedoBand, normalBand);
+        instance.outputProcess->setDst(outputBand);
       }
 
-      // Iterate over the tiles
+      // Rows shared by consecutive bands are kept in the bands instead of streaming them again
+      const int bandOverlap = 2*tileOverlap + tilePadH;
       int tileIndex = 0;
 
       for (int i = 0; i < tileCountH; ++i)
       {
-        const int h = i * (tileH - (2*tileOverlap+tilePadH)); // input tile position (including overlaps)
+        const int h = i * (tileH - bandOverlap); // input band position (including overlaps)
         const int overlapBeginH = i > 0            ? tileOverlap : 0; // overlap on the top
         const int overlapEndH   = i < tileCountH-1 ? tileOverlap+tilePadH : 0; // overlap on the bottom
-        const int tileH1 = min(H - h, tileH); // input tile size (including overlaps)
-        const int tileH2 = tileH1 - overlapBeginH - overlapEndH; // output tile size
+        const int tileH1 = min(H - h, tileH); // input band size (including overlaps)
+        const int tileH2 = tileH1 - overlapBeginH - overlapEndH; // output band size
         const int alignOffsetH = tileH - round_up(tileH1, minTileAlignment); // align to the bottom in the tile buffer
 
+        // Read the rows of the input band
+        const int keepH = i > 0 ? bandOverlap : 0;
+        for (const auto& imagePair : {std::make_pair(color, colorBand),
+                                      std::make_pair(albedo, albedoBand),
+                                      std::make_pair(normal, normalBand)})
+        {
+          const auto& image = imagePair.first;
+          const auto& band  = imagePair.second;
+          if (!image)
+            continue;
+
+          char* bandPtr = static_cast<char*>(band->getBuffer()->getHostPtr());
+          const size_t rowByteStride = band->getDesc().hByteStride;
+          if (keepH > 0)
+            std::memmove(bandPtr, bandPtr + (tileH - keepH) * rowByteStride, keepH * rowByteStride);
+
+          const ImageStream& stream = image->getStream();
+          if (tileH1 > keepH && !stream.func(stream.userPtr, h + keepH, tileH1 - keepH,
+                                             bandPtr + keepH * rowByteStride, rowByteStride))
+            throw Exception(Error::Cancelled, "execution was cancelled");
+        }
+
+        // Denoise the tiles of the band
         for (int j = 0; j < tileCountW; ++j)
         {
           const int w = j * (tileW - (2*tileOverlap+tilePadW)); // input tile position (including overlaps)
@@ -218,37 +527,124 @@ OIDN_NAMESPACE_BEGIN
 
           auto& instance = instances[tileIndex % device->getNumSubdevices()];
 
-          // Set the input tile
           instance.inputProcess->setTile(
-            h, w,
+            0, w,
             alignOffsetH, alignOffsetW,
             tileH1, tileW1);
 
-          // Set the output tile
           instance.outputProcess->setTile(
             alignOffsetH + overlapBeginH, alignOffsetW + overlapBeginW,
-            h + overlapBeginH, w + overlapBeginW,
+            overlapBeginH, w + overlapBeginW,
             tileH2, tileW2);
 
-          //printf("Tile: %d %d -> %d %d\n", w+overlapBeginW, h+overlapBeginH, w+overlapBeginW+tileW2, h+overlapBeginH+tileH2);
-
-          // Denoise the tile
           instance.graph->submit(progress);
-
-          // Next tile
           tileIndex++;
         }
+
+        // Write the rows of the output band, which are final
+        device->wait();
+        const ImageStream& outputStream = output->getStream();
+        const size_t outputRowByteStride = outputBand->getDesc().hByteStride;
+        char* outputBandPtr = static_cast<char*>(outputBand->getBuffer()->getHostPtr());
+        if (!outputStream.func(outputStream.userPtr, h + overlapBeginH, tileH2,
+                               outputBandPtr + overlapBeginH * outputRowByteStride, outputRowByteStride))
+          throw Exception(Error::Cancelled, "execution was cancelled");
       }
+    });
 
-      device->submitBarrier();
+    reportProfile();
+  }
 
-      // Copy the output image to the final buffer if filtering in-place
-      if (outputTemp)
+  void UNetFilter::submitPipelinedTile(const Ref<Graph>& graph, const Ref<Progress>& progress)
+  {
+    // Stagger the tiles by half of the operations: the first half of the new tile (high resolution
+    // encoder) and the second half of the previous tile (low resolution decoder) are submitted as
+    // independent lanes, which execute concurrently without synchronizing between their operations
+    std::vector<std::function<void()>> funcs;
+    if (pipelinedGraph)
+    {
+      Ref<Graph> prevGraph = pipelinedGraph;
+      funcs.push_back([prevGraph, progress]()
+      {
+        prevGraph->submit(progress, prevGraph->getNumOps() / 2, prevGraph->getNumOps());
+      });
+    }
+    funcs.push_back([graph, progress]()
+    {
+      graph->submit(progress, 0, graph->getNumOps() / 2);
+    });
+
+    device->getEngine()->submitConcurrent(funcs);
+    pipelinedGraph = graph;
+  }
+
+  void UNetFilter::flushPipeline(const Ref<Progress>& progress)
+  {
+    if (!pipelinedGraph)
+      return;
+
+    pipelinedGraph->submit(progress, pipelinedGraph->getNumOps() / 2, pipelinedGraph->getNumOps());
+    pipelinedGraph.reset();
+  }
+
+  void UNetFilter::reportProfile()
+  {
+    if (profiler)
+    {
+      if (device->isVerbose(2))
+        profiler->print();
+
+      if (profilingFunc)
       {
-        imageCopy->setDst(output);
-        imageCopy->submit(progress);
+        const auto& records = profiler->getRecords();
+        profilingFunc(profilingUserPtr, records.data(), int(records.size()));
       }
-    }, sync);
+    }
+  }
+
+  void UNetFilter::submitOp(const Ref<Op>& op, const Ref<Progress>& progress)
+  {
+    if (profiler)
+      profiler->submit(op.get(), progress);
+    else
+      op->submit(progress);
+  }
+
+  void UNetFilter::submitAutoexposure(const Ref<Progress>& progress)
+  {
+    for (int b = 0; b < batchSize; ++b)
+    {
+      autoexposure->setSrc(getBatchImage(color, b));
+      autoexposure->setDst(autoexposureDsts[b]);
+      submitOp(autoexposure, progress);
+    }
+  }
+
+  void UNetFilter::submitTemporalAutoexposureUpdate()
+  {
+    // Read the autoexposure results back to the host and blend them with the previous input scales
+    // in the log domain when they are available, without blocking
+    auto state = temporalAutoexposureState;
+    for (int b = 0; b < batchSize; ++b)
+    {
+      const auto& dst = autoexposureDsts[b];
+      dst->getBuffer()->read(dst->getByteOffset(), sizeof(float), &state->results[b], SyncMode::Async);
+    }
+
+    const float smoothing = autoexposureSmoothing;
+    autoexposure->getEngine()->submitHostFunc([state, smoothing]()
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      for (size_t b = 0; b < state->scales.size(); ++b)
+      {
+        const float result = state->results[b];
+        float& scale = state->scales[b];
+        if (math::isnan(scale) || !(scale > 0.f) || !(result > 0.f))
+          scale = result;
+        else
+          scale = math::exp2(smoothing * math::log2(scale) + (1.f - smoothing) * math::log2(result));
+      }
+    });
   }
 
   void UNetFilter::init()
@@ -256,35 +652,76 @@ OIDN_NAMESPACE_BEGIN
     cleanup();
     checkParams();
 
+    streaming = output->isStream();
+
     // Select the model
     Data weightsBlob = getWeights();
     auto constTensors = parseTZA(weightsBlob.ptr, weightsBlob.size);
-    const bool fastMath = quality != Quality::High;
+    const bool fastMath  = quality != Quality::High;
+    const bool quantized = quality == Quality::Preview;
     largeModel = constTensors->find("enc_conv1b.weight") != constTensors->end();
 
     // Compute final device-dependent tile alignment and overlap
     const int receptiveField = largeModel ? receptiveFieldLarge : receptiveFieldBase;
     tileAlignment = lcm(minTileAlignment, device->getMinTileAlignment());
     tileOverlap = round_up(receptiveField / 2, tileAlignment);
+    auxTileOverlap = 0;
 
-    // Build the model
-    for (int i = 0; i < device->getNumSubdevices(); ++i)
+    // Add the weights of the auxiliary prefiltering models with prefixed names, so all networks
+    // can be part of the same graph
+    if (prefilterAux)
     {
-      Engine* engine = device->getEngine(i);
+      const Data albedoWeightsBlob = getWeights(models.alb);
+      const Data normalWeightsBlob = getWeights(models.nrm);
+      auto albedoTensors = parseTZA(albedoWeightsBlob.ptr, albedoWeightsBlob.size);
+      auto normalTensors = parseTZA(normalWeightsBlob.ptr, normalWeightsBlob.size);
+      largeAlbedoModel = albedoTensors->find("enc_conv1b.weight") != albedoTensors->end();
+      largeNormalModel = normalTensors->find("enc_conv1b.weight") != normalTensors->end();
+
+      constTensors = std::make_shared<TensorMap>(*constTensors);
+      for (const auto& item : *albedoTensors)
+        (*constTensors)["alb." + item.first] = item.second;
+      for (const auto& item : *normalTensors)
+        (*constTensors)["nrm." + item.first] = item.second;
+
+      // The prefiltered auxiliary features must be correct in the whole input tile of the main
+      // network, thus the prefiltering tiles are extended by their own receptive field
+      const int auxReceptiveField = (largeAlbedoModel || largeNormalModel) ? receptiveFieldLarge
+                                                                           : receptiveFieldBase;
+      auxTileOverlap = round_up(auxReceptiveField / 2, tileAlignment);
+    }
 
+    // Profile the operations if enabled for the device
+    if (device->isProfiling())
+      profiler = std::make_shared<Profiler>();
+
+    // Build the model
+    auto addInstance = [&](Engine* engine)
+    {
       // We can use cached weights only for built-in weights because user weights may change!
       auto cachedConstTensors =
-        userWeightsBlob ? nullptr : engine->getSubdevice()->getCachedTensors(weightsBlob.ptr);
+        userWeightsBlob ? nullptr : engine->getSubdevice()->getCachedTensors(weightsBlob);
 
       instances.emplace_back();
-      instances.back().graph = makeRef<Graph>(engine, constTensors, cachedConstTensors, fastMath);
-    }
+      instances.back().graph = makeRef<Graph>(engine, constTensors, cachedConstTensors,
+                                                   fastMath, quantized);
+      instances.back().graph->setProfiler(profiler);
+      instances.back().transferFunc = newTransferFunc();
+    };
 
-    transferFunc = newTransferFunc();
+    for (int i = 0; i < device->getNumSubdevices(); ++i)
+      addInstance(device->getEngine(i));
+
+    if (prefilterAux)
+    {
+      // Same as for filtering the auxiliary images separately
+      albedoTransferFunc = std::make_shared<TransferFunction>(TransferFunction::Type::SRGB);
+      normalTransferFunc = std::make_shared<TransferFunction>(TransferFunction::Type::Linear);
+    }
 
     // Try to divide the image into tiles until the memory usage gets below the specified threshold
-    // and the number of tiles is a multiple of the number of subdevices
-    H = output->getH();
+    // and the total number of tiles in the batch is a multiple of the number of subdevices
+    H = output->getH() / batchSize;
     W = output->getW();
     tileH = round_up(H, minTileAlignment); // add minimum device-independent padding
     tileW = round_up(W, minTileAlignment);
@@ -300,23 +737,13 @@ OIDN_NAMESPACE_BEGIN
     const int maxTileSize = (maxMemoryMB < 0) ? defaultMaxTileSize : INT_MAX;
     const size_t maxMemoryByteSize = (maxMemoryMB >= 0) ? size_t(maxMemoryMB)*1024*1024 : SIZE_MAX;
 
-    while ((tileCountH * tileCountW) % device->getNumSubdevices() != 0 ||
+    // Streamed images are processed in bands of at most minimum tile height to bound the memory usage
+    while ((batchSize * tileCountH * tileCountW) % device->getNumSubdevices() != 0 ||
            (tileH * tileW) > maxTileSize ||
+           (streaming && tileH > minTileH) ||
            !buildModel(maxMemoryByteSize))
     {
-      if (tileH > minTileH && tileH > tileW)
-      {
-        const int newTileH = ceil_div(H + (2*tileOverlap+tilePadH) * tileCountH, tileCountH + 1);
-        tileH = clamp(round_up(newTileH, tileAlignment, tilePadH), minTileH, tileH - tileAlignment);
-        tileCountH = max(ceil_div(H - (2*tileOverlap+tilePadH), tileH - (2*tileOverlap+tilePadH)), 1);
-      }
-      else if (tileW > minTileW)
-      {
-        const int newTileW = ceil_div(W + (2*tileOverlap+tilePadW) * tileCountW, tileCountW + 1);
-        tileW = clamp(round_up(newTileW, tileAlignment, tilePadW), minTileW, tileW - tileAlignment);
-        tileCountW = max(ceil_div(W - (2*tileOverlap+tilePadW), tileW - (2*tileOverlap+tilePadW)), 1);
-      }
-      else
+      if (!splitTiles(minTileH, minTileW))
       {
         // Cannot divide further
         if (!buildModel())
@@ -325,22 +752,232 @@ OIDN_NAMESPACE_BEGIN
       }
     }
 
+    // Optionally select the fastest tile size among the ones that fit in the memory limit
+    // Streamed images are not stored in memory, so the tiles cannot be measured
+    if (autotune && !streaming)
+      tuneTileSize(weightsBlob, maxMemoryByteSize);
+
+    // Pipeline the tiles with a second model instance if the engine can execute the operations of
+    // consecutive tiles concurrently and the tensors of both instances fit in the memory limit.
+    // The operations of each tile have low parallelism at the lowest resolutions, which can be
+    // filled with the operations of the other tile. Profiling measures the operations separately.
+    if (device->getNumSubdevices() == 1 && !streaming && !profiler && device->isTilePipeliningEnabled() &&
+        batchSize * tileCountH * tileCountW > 1 &&
+        device->getEngine()->isConcurrentSubmitSupported())
+    {
+      resetModel();
+      addInstance(device->getEngine());
+      pipelined = buildModel(maxMemoryByteSize);
+
+      if (!pipelined)
+      {
+        instances.pop_back();
+        if (!buildModel(maxMemoryByteSize) && !buildModel())
+          throw std::runtime_error("could not build filter model");
+      }
+    }
+
+    // Allocate the host memory bands for the streamed images, which hold a row of tiles
+    if (streaming)
+    {
+      auto newBand = [&](const Ref<Image>& image) -> Ref<Image>
+      {
+        if (!image)
+          return nullptr;
+        ImageDesc bandDesc(image->getFormat(), W, tileH);
+        auto bandBuffer = device->getEngine()->newBuffer(bandDesc.getByteSize(), Storage::Host);
+        return bandBuffer->newImage(bandDesc);
+      };
+
+      colorBand  = newBand(color);
+      albedoBand = newBand(albedo);
+      normalBand = newBand(normal);
+      outputBand = newBand(output);
+    }
+
+    // Store the newly reordered built-in weights in the on-disk cache (if enabled)
+    if (!userWeightsBlob)
+    {
+      for (int i = 0; i < device->getNumSubdevices(); ++i)
+        device->getSubdevice(i)->saveCachedTensors(weightsBlob);
+    }
+    weightCacheLoaded = !userWeightsBlob && device->getSubdevice(0)->isWeightCacheLoaded(weightsBlob);
+
     if (device->isVerbose(2))
     {
       std::cout << "Image size: " << W << "x" << H << std::endl;
+      std::cout << "Batch size: " << batchSize << std::endl;
       std::cout << "Tile size : " << tileW << "x" << tileH << std::endl;
       std::cout << "Tile count: " << tileCountW << "x" << tileCountH << std::endl;
+      std::cout << "Autotune  : " << (autotune ? "true" : "false") << std::endl;
       std::cout << "In-place  : " << (inplace ? "true" : "false") << std::endl;
+      std::cout << "Pipelined : " << (pipelined ? "true" : "false") << std::endl;
     }
   }
 
+  bool UNetFilter::splitTiles(int minTileH, int minTileW)
+  {
+    if (tileH > minTileH && tileH > tileW)
+    {
+      const int newTileH = ceil_div(H + (2*tileOverlap+tilePadH) * tileCountH, tileCountH + 1);
+      tileH = clamp(round_up(newTileH, tileAlignment, tilePadH), minTileH, tileH - tileAlignment);
+      tileCountH = getTileCount(H, tileH, tilePadH);
+    }
+    else if (tileW > minTileW)
+    {
+      const int newTileW = ceil_div(W + (2*tileOverlap+tilePadW) * tileCountW, tileCountW + 1);
+      tileW = clamp(round_up(newTileW, tileAlignment, tilePadW), minTileW, tileW - tileAlignment);
+      tileCountW = getTileCount(W, tileW, tilePadW);
+    }
+    else
+      return false;
+
+    return true;
+  }
+
+  int UNetFilter::getTileCount(int size, int tileSize, int tilePad) const
+  {
+    return max(ceil_div(size - (2*tileOverlap+tilePad), tileSize - (2*tileOverlap+tilePad)), 1);
+  }
+
+  void UNetFilter::tuneTileSize(const Data& weightsBlob, size_t maxMemoryByteSize)
+  {
+    // The tuned tile size depends on the model and the image configuration. The model is identified
+    // by the contents of the weights because user weights may be reallocated at the same address
+    std::stringstream keyStream;
+    keyStream << std::hex << weightsBlob.getHash() << std::dec << "_" << int(quality) << "_" << W << "x" << H << "x" << batchSize
+              << "_" << int(output->getFormat()) << "_" << inplace << "_" << prefilterAux
+              << "_" << maxMemoryMB;
+    const std::string key = keyStream.str();
+
+    // Reuse the tile size tuned previously for the same configuration
+    int tunedTileH = 0, tunedTileW = 0;
+    if (device->getTunedTileSize(key, tunedTileH, tunedTileW))
+    {
+      if (tunedTileH != tileH || tunedTileW != tileW)
+      {
+        resetModel();
+        tileH = tunedTileH;
+        tileW = tunedTileW;
+        tileCountH = getTileCount(H, tileH, tilePadH);
+        tileCountW = getTileCount(W, tileW, tilePadW);
+        if (!buildModel(maxMemoryByteSize))
+          throw std::runtime_error("could not build filter model");
+      }
+      return;
+    }
+
+    // Measure the estimated execution time of the largest tiles that fit and a few smaller ones,
+    // which may be faster because of better cache locality despite the overhead of the overlaps
+    struct TileConfig
+    {
+      int tileH, tileW, tileCountH, tileCountW;
+      double time;
+    };
+
+    const int numTiles = batchSize * tileCountH * tileCountW;
+    TileConfig bestConfig{tileH, tileW, tileCountH, tileCountW,
+                          measureTileTime() * numTiles / device->getNumSubdevices()};
+
+    if (device->isVerbose(2))
+      std::cout << "Tile tuning: " << tileW << "x" << tileH << ": " << bestConfig.time * 1000 << " msec" << std::endl;
+
+    const int minTileDim = max(4*tileOverlap, int(minTunedTileSize));
+    const int minTileH = round_up(minTileDim, tileAlignment, tilePadH);
+    const int minTileW = round_up(minTileDim, tileAlignment, tilePadW);
+
+    for (int i = 0; i < maxTunedTileSizes - 1 && splitTiles(minTileH, minTileW); )
+    {
+      const int numTiles = batchSize * tileCountH * tileCountW;
+      if (numTiles % device->getNumSubdevices() != 0)
+        continue;
+
+      resetModel();
+      if (!buildModel(maxMemoryByteSize))
+        continue;
+
+      const double time = measureTileTime() * numTiles / device->getNumSubdevices();
+      if (device->isVerbose(2))
+        std::cout << "Tile tuning: " << tileW << "x" << tileH << ": " << time * 1000 << " msec" << std::endl;
+
+      if (time < bestConfig.time)
+        bestConfig = {tileH, tileW, tileCountH, tileCountW, time};
+      ++i;
+    }
+
+    // Rebuild the model with the fastest tile size
+    resetModel();
+    tileH = bestConfig.tileH;
+    tileW = bestConfig.tileW;
+    tileCountH = bestConfig.tileCountH;
+    tileCountW = bestConfig.tileCountW;
+    if (!buildModel(maxMemoryByteSize))
+      throw std::runtime_error("could not build filter model");
+
+    device->setTunedTileSize(key, tileH, tileW);
+  }
+
+  double UNetFilter::measureTileTime()
+  {
+    // Denoise the first tile of the first image into a temporary image to avoid overwriting the
+    // input when filtering in-place
+    auto& instance = instances[0];
+    const int tileH1 = min(H, tileH);
+    const int tileW1 = min(W, tileW);
+    const int alignOffsetH = tileH - round_up(tileH1, minTileAlignment);
+    const int alignOffsetW = tileW - round_up(tileW1, minTileAlignment);
+
+    ImageDesc tempDesc(output->getFormat(), tileW1, tileH1);
+    auto tempBuffer = device->getEngine()->newBuffer(tempDesc.getByteSize(), Storage::Device);
+    auto temp = tempBuffer->newImage(tempDesc);
+
+    instance.transferFunc->setInputScale(math::isnan(inputScale) ? 1.f : inputScale);
+    if (prefilterAux)
+    {
+      instance.albedoInputProcess->setSrc(nullptr, getBatchImage(albedo, 0), nullptr);
+      instance.normalInputProcess->setSrc(nullptr, nullptr, getBatchImage(normal, 0));
+      setAuxTile(0, getBatchImage(color, 0), 0, 0, tileH1, tileW1);
+    }
+    else
+      instance.inputProcess->setSrc(getBatchImage(color, 0), getBatchImage(albedo, 0), getBatchImage(normal, 0));
+    instance.inputProcess->setTile(0, 0, alignOffsetH, alignOffsetW, tileH1, tileW1);
+    instance.outputProcess->setDst(temp);
+    instance.outputProcess->setTile(alignOffsetH, alignOffsetW, 0, 0, tileH1, tileW1);
+
+    // Use the fastest of a few runs after a warmup run
+    double time = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < 3; ++i)
+    {
+      Timer timer;
+      instance.graph->submit(nullptr);
+      device->wait();
+      if (i > 0)
+        time = min(time, timer.query());
+    }
+
+    return time;
+  }
+
   void UNetFilter::cleanup()
   {
     instances.clear();
-    transferFunc.reset();
+    pipelined = false;
+    pipelinedGraph.reset();
+    weightCacheLoaded = false;
+    coverageDirty = true;
+    albedoTransferFunc.reset();
+    normalTransferFunc.reset();
     autoexposure.reset();
+    autoexposureDsts.clear();
+    autoexposureCached = false;
+    temporalAutoexposureState.reset();
     imageCopy.reset();
     outputTemp.reset();
+    profiler.reset();
+    colorBand.reset();
+    albedoBand.reset();
+    normalBand.reset();
+    outputBand.reset();
   }
 
   void UNetFilter::checkParams()
@@ -374,6 +1011,30 @@ OIDN_NAMESPACE_BEGIN
         (normal && (normal->getW() != output->getW() || normal->getH() != output->getH())))
       throw Exception(Error::InvalidOperation, "image size mismatch");
 
+    if (output->getH() % batchSize != 0)
+      throw Exception(Error::InvalidOperation, "image height is not a multiple of the batch size");
+
+    if ((color  && color->isStream()  != output->isStream()) ||
+        (albedo && albedo->isStream() != output->isStream()) ||
+        (normal && normal->isStream() != output->isStream()))
+      throw Exception(Error::InvalidOperation, "streamed and stored images cannot be mixed");
+    if (output->isStream() && batchSize != 1)
+      throw Exception(Error::InvalidOperation, "batched filtering is not supported for streamed images");
+    if (output->isStream() && prefilterAux)
+      throw Exception(Error::InvalidOperation, "prefiltering auxiliary images is not supported for streamed images");
+    if (output->isStream() && hdr && math::isnan(inputScale))
+      throw Exception(Error::InvalidOperation, "inputScale must be set when streaming HDR images");
+
+    if (coverage)
+    {
+      if (!isSupportedFormat(coverage->getFormat()))
+        throw Exception(Error::InvalidOperation, "unsupported coverage image format");
+      if (coverage->getW() != output->getW() || coverage->getH() != output->getH())
+        throw Exception(Error::InvalidOperation, "image size mismatch");
+      if (coverage->isStream() || output->isStream())
+        throw Exception(Error::InvalidOperation, "coverage image is not supported for streamed images");
+    }
+
     if (directional && (hdr || srgb))
       throw Exception(Error::InvalidOperation, "directional and hdr/srgb modes cannot be enabled at the same time");
     if (hdr && srgb)
@@ -386,6 +1047,7 @@ OIDN_NAMESPACE_BEGIN
       if (color)  std::cout << " " << (directional ? "dir" : (hdr ? "hdr" : "ldr")) << ":" << color->getFormat();
       if (albedo) std::cout << " " << "alb" << ":" << albedo->getFormat();
       if (normal) std::cout << " " << "nrm" << ":" << normal->getFormat();
+      if (prefilterAux) std::cout << " (prefiltered aux)";
       std::cout << std::endl;
       std::cout << "Output: " << output->getFormat() << std::endl;
     }
@@ -396,7 +1058,14 @@ OIDN_NAMESPACE_BEGIN
     // Select the model to use
     Model* model = nullptr;
 
-    if (color)
+    if (prefilterAux)
+    {
+      // The auxiliary images are prefiltered, so they are clean for the main model
+      if (!color || !albedo || !normal)
+        throw Exception(Error::InvalidOperation, "prefiltering auxiliary images requires color, albedo and normal images");
+      model = hdr ? &models.hdr_calb_cnrm : &models.ldr_calb_cnrm;
+    }
+    else if (color)
     {
       if (!albedo && !normal)
       {
@@ -439,24 +1108,34 @@ OIDN_NAMESPACE_BEGIN
     Data weightsBlob = nullptr;
 
     if (userWeightsBlob)
-    {
       weightsBlob = userWeightsBlob;
-    }
     else if (model)
+      weightsBlob = getWeights(*model);
+
+    if (!weightsBlob)
+      throw Exception(Error::InvalidOperation, "unsupported combination of input features");
+
+    return weightsBlob;
+  }
+
+  Data UNetFilter::getWeights(const Model& model)
+  {
+    // Select the built-in weights matching the quality
+    Data weightsBlob = nullptr;
+
+    switch (quality)
     {
-      switch (quality)
-      {
-      case Quality::Default:
-      case Quality::High:
-        weightsBlob = model->large ? model->large : model->base;
-        break;
-      case Quality::Balanced:
-        weightsBlob = model->base;
-        break;
-      case Quality::Fast:
-        weightsBlob = model->small ? model->small : model->base;
-        break;
-      }
+    case Quality::Default:
+    case Quality::High:
+      weightsBlob = model.large ? model.large : model.base;
+      break;
+    case Quality::Balanced:
+      weightsBlob = model.base;
+      break;
+    case Quality::Fast:
+    case Quality::Preview:
+      weightsBlob = model.small ? model.small : model.base;
+      break;
     }
 
     if (!weightsBlob)
@@ -465,71 +1144,287 @@ OIDN_NAMESPACE_BEGIN
     return weightsBlob;
   }
 
-  Ref<Op> UNetFilter::addUNet(const Ref<Graph>& graph, const Ref<Op>& inputProcess)
+  Ref<Image> UNetFilter::getBatchImage(const Ref<Image>& image, int b) const
+  {
+    if (!image || batchSize == 1)
+      return image;
+    return image->newSubImage(size_t(b) * H, 0, H, W);
+  }
+
+  std::vector<UNetFilter::Region> UNetFilter::getRegions() const
+  {
+    // Clip the region of interest to the image
+    Region roi{0, 0, H, W};
+    if (roiWidth > 0 && roiHeight > 0)
+    {
+      roi.h = clamp(roiY, 0, H);
+      roi.w = clamp(roiX, 0, W);
+      roi.H = clamp(roiY + roiHeight, 0, H) - roi.h;
+      roi.W = clamp(roiX + roiWidth,  0, W) - roi.w;
+    }
+
+    std::vector<Region> regions;
+    auto addRegion = [&](int h, int w, int regionH, int regionW)
+    {
+      const int beginH = max(h, roi.h);
+      const int beginW = max(w, roi.w);
+      const int endH = min(h + regionH, roi.h + roi.H);
+      const int endW = min(w + regionW, roi.w + roi.W);
+      if (beginH < endH && beginW < endW)
+        regions.push_back({beginH, beginW, endH - beginH, endW - beginW});
+    };
+
+    // Clip the dirty rectangles to the region of interest
+    if (dirtyRects)
+    {
+      const int* rects = static_cast<const int*>(dirtyRects.ptr);
+      const size_t numRects = dirtyRects.size / (4 * sizeof(int));
+      for (size_t i = 0; i < numRects; ++i)
+      {
+        const int* rect = &rects[i * 4]; // x, y, width, height
+        addRegion(rect[1], rect[0], rect[3], rect[2]);
+      }
+    }
+    else
+      addRegion(roi.h, roi.w, roi.H, roi.W);
+
+    // Merge the overlapping regions into their bounding boxes, so no pixel is denoised twice
+    bool merged = true;
+    while (merged)
+    {
+      merged = false;
+      for (size_t i = 0; i < regions.size() && !merged; ++i)
+      {
+        for (size_t j = i + 1; j < regions.size() && !merged; ++j)
+        {
+          Region& a = regions[i];
+          const Region& b = regions[j];
+          if (a.h < b.h + b.H && b.h < a.h + a.H && a.w < b.w + b.W && b.w < a.w + a.W)
+          {
+            const int endH = max(a.h + a.H, b.h + b.H);
+            const int endW = max(a.w + a.W, b.w + b.W);
+            a.h = min(a.h, b.h);
+            a.w = min(a.w, b.w);
+            a.H = endH - a.h;
+            a.W = endW - a.w;
+            regions.erase(regions.begin() + j);
+            merged = true;
+          }
+        }
+      }
+    }
+
+    return regions;
+  }
+
+  bool UNetFilter::needsOutputTemp() const
+  {
+    return inplace && (batchSize * tileCountH * tileCountW > 1 || dirtyRects);
+  }
+
+  bool UNetFilter::isFullRegion(const std::vector<Region>& regions) const
+  {
+    return regions.size() == 1 && regions[0].h == 0 && regions[0].w == 0 &&
+           regions[0].H == H && regions[0].W == W;
+  }
+
+  void UNetFilter::forEachTile(const std::vector<Region>& regions, int b,
+                               const std::function<void(const TileDesc&)>& func) const
+  {
+    for (const auto& region : regions)
+    {
+      // Extend the region by the tile overlaps, keeping the tile offsets aligned
+      const int regionBeginH = max(region.h - tileOverlap, 0) / tileAlignment * tileAlignment;
+      const int regionBeginW = max(region.w - tileOverlap, 0) / tileAlignment * tileAlignment;
+      const int regionEndH = min(region.h + region.H + tileOverlap, H);
+      const int regionEndW = min(region.w + region.W + tileOverlap, W);
+      const int regionTileCountH = getTileCount(regionEndH - regionBeginH, tileH, tilePadH);
+      const int regionTileCountW = getTileCount(regionEndW - regionBeginW, tileW, tilePadW);
+
+      for (int i = 0; i < regionTileCountH; ++i)
+      {
+        TileDesc tile;
+        tile.h = regionBeginH + i * (tileH - (2*tileOverlap+tilePadH)); // input tile position (including overlaps)
+        tile.H1 = min(regionEndH - tile.h, tileH); // input tile size (including overlaps)
+        const int overlapBeginH = tile.h > 0 ? tileOverlap : 0; // overlap on the top
+        const int overlapEndH   = i < regionTileCountH-1 ? tileOverlap+tilePadH :
+                                  (tile.h + tile.H1 < H ? tileOverlap : 0); // overlap on the bottom
+        tile.outputH = max(tile.h + overlapBeginH, region.h); // output tile position (clipped to the region)
+        tile.H2 = min(tile.h + tile.H1 - overlapEndH, region.h + region.H) - tile.outputH; // output tile size
+        tile.alignOffsetH = tileH - round_up(tile.H1, minTileAlignment); // align to the bottom in the tile buffer
+
+        for (int j = 0; j < regionTileCountW; ++j)
+        {
+          tile.w = regionBeginW + j * (tileW - (2*tileOverlap+tilePadW)); // input tile position (including overlaps)
+          tile.W1 = min(regionEndW - tile.w, tileW); // input tile size (including overlaps)
+          const int overlapBeginW = tile.w > 0 ? tileOverlap : 0; // overlap on the left
+          const int overlapEndW   = j < regionTileCountW-1 ? tileOverlap+tilePadW :
+                                    (tile.w + tile.W1 < W ? tileOverlap : 0); // overlap on the right
+          tile.outputW = max(tile.w + overlapBeginW, region.w); // output tile position (clipped to the region)
+          tile.W2 = min(tile.w + tile.W1 - overlapEndW, region.w + region.W) - tile.outputW; // output tile size
+          tile.alignOffsetW = tileW - round_up(tile.W1, minTileAlignment); // align to the right in the tile buffer
+
+          // Skip the tile if its output is completely empty
+          if (coverage && !isCovered(b, tile.outputH, tile.outputW, tile.H2, tile.W2))
+            continue;
+
+          func(tile);
+        }
+      }
+    }
+  }
+
+  void UNetFilter::updateCoverageBlocks()
+  {
+    // Copy the coverage image to the host if necessary
+    const char* coveragePtr = static_cast<const char*>(coverage->getPtr());
+    std::vector<char> coverageHost;
+    const Storage storage = coverage->getBuffer() ? coverage->getBuffer()->getStorage()
+                                                  : device->getPtrStorage(coveragePtr);
+    if (storage == Storage::Device)
+    {
+      coverageHost.resize(coverage->getByteSize());
+      device->getEngine()->usmCopy(coverageHost.data(), coveragePtr, coverageHost.size());
+      coveragePtr = coverageHost.data();
+    }
+
+    // A block is covered if the first channel of any of its pixels is non-zero
+    const ImageDesc& desc = coverage->getDesc();
+    const bool isHalf = desc.getDataType() == DataType::Float16;
+    coverageBlocksH = ceil_div(H, coverageBlockSize);
+    coverageBlocksW = ceil_div(W, coverageBlockSize);
+    coverageBlocks.assign(size_t(batchSize) * coverageBlocksH * coverageBlocksW, false);
+
+    for (int h = 0; h < batchSize * H; ++h)
+    {
+      const int b = h / H;
+      const char* row = coveragePtr + size_t(h) * desc.hByteStride;
+      for (int w = 0; w < W; ++w)
+      {
+        const char* pixel = row + size_t(w) * desc.wByteStride;
+        const float value = isHalf ? float(*reinterpret_cast<const half*>(pixel))
+                                   : *reinterpret_cast<const float*>(pixel);
+        if (value != 0.f)
+          coverageBlocks[(size_t(b) * coverageBlocksH + (h % H) / coverageBlockSize) * coverageBlocksW +
+                         w / coverageBlockSize] = true;
+      }
+    }
+  }
+
+  bool UNetFilter::isCovered(int b, int h, int w, int regionH, int regionW) const
   {
-    auto x = graph->addConv("enc_conv0", inputProcess, Activation::ReLU);
+    for (int i = h / coverageBlockSize; i <= (h + regionH - 1) / coverageBlockSize; ++i)
+    {
+      for (int j = w / coverageBlockSize; j <= (w + regionW - 1) / coverageBlockSize; ++j)
+      {
+        if (coverageBlocks[(size_t(b) * coverageBlocksH + i) * coverageBlocksW + j])
+          return true;
+      }
+    }
+    return false;
+  }
+
+  Ref<Op> UNetFilter::addUNet(const Ref<Graph>& graph, const Ref<Op>& inputProcess,
+                               const std::string& prefix)
+  {
+    auto x = graph->addConv(prefix + "enc_conv0", inputProcess, Activation::ReLU);
 
-    auto pool1 = x = graph->addConv("enc_conv1", x, Activation::ReLU, PostOp::Pool);
+    auto pool1 = x = graph->addConv(prefix + "enc_conv1", x, Activation::ReLU, PostOp::Pool);
 
-    auto pool2 = x = graph->addConv("enc_conv2", x, Activation::ReLU, PostOp::Pool);
+    auto pool2 = x = graph->addConv(prefix + "enc_conv2", x, Activation::ReLU, PostOp::Pool);
 
-    auto pool3 = x = graph->addConv("enc_conv3", x, Activation::ReLU, PostOp::Pool);
+    auto pool3 = x = graph->addConv(prefix + "enc_conv3", x, Activation::ReLU, PostOp::Pool);
 
-    auto pool4 = x = graph->addConv("enc_conv4", x, Activation::ReLU, PostOp::Pool);
+    auto pool4 = x = graph->addConv(prefix + "enc_conv4", x, Activation::ReLU, PostOp::Pool);
 
-    x = graph->addConv("enc_conv5a", pool4, Activation::ReLU);
-    x = graph->addConv("enc_conv5b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConv(prefix + "enc_conv5a", pool4, Activation::ReLU);
+    x = graph->addConv(prefix + "enc_conv5b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv4a", x, pool3, Activation::ReLU);
-    x = graph->addConv("dec_conv4b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv4a", x, pool3, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv4b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv3a", x, pool2, Activation::ReLU);
-    x = graph->addConv("dec_conv3b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv3a", x, pool2, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv3b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv2a", x, pool1, Activation::ReLU);
-    x = graph->addConv("dec_conv2b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv2a", x, pool1, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv2b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv1a", x, inputProcess, Activation::ReLU);
-    x = graph->addConv("dec_conv1b", x, Activation::ReLU);
+    x = graph->addConcatConv(prefix + "dec_conv1a", x, inputProcess, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv1b", x, Activation::ReLU);
 
-    x = graph->addConv("dec_conv0", x, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv0", x, Activation::ReLU);
 
     return x;
   }
 
-  Ref<Op> UNetFilter::addUNetLarge(const Ref<Graph>& graph, const Ref<Op>& inputProcess)
+  Ref<Op> UNetFilter::addUNetLarge(const Ref<Graph>& graph, const Ref<Op>& inputProcess,
+                                    const std::string& prefix)
   {
-    auto x = graph->addConv("enc_conv1a", inputProcess, Activation::ReLU);
-    auto pool1 = x = graph->addConv("enc_conv1b", x, Activation::ReLU, PostOp::Pool);
+    auto x = graph->addConv(prefix + "enc_conv1a", inputProcess, Activation::ReLU);
+    auto pool1 = x = graph->addConv(prefix + "enc_conv1b", x, Activation::ReLU, PostOp::Pool);
 
-    x = graph->addConv("enc_conv2a", x, Activation::ReLU);
-    auto pool2 = x = graph->addConv("enc_conv2b", x, Activation::ReLU, PostOp::Pool);
+    x = graph->addConv(prefix + "enc_conv2a", x, Activation::ReLU);
+    auto pool2 = x = graph->addConv(prefix + "enc_conv2b", x, Activation::ReLU, PostOp::Pool);
 
-    x = graph->addConv("enc_conv3a", x, Activation::ReLU);
-    auto pool3 = x = graph->addConv("enc_conv3b", x, Activation::ReLU, PostOp::Pool);
+    x = graph->addConv(prefix + "enc_conv3a", x, Activation::ReLU);
+    auto pool3 = x = graph->addConv(prefix + "enc_conv3b", x, Activation::ReLU, PostOp::Pool);
 
-    x = graph->addConv("enc_conv4a", x, Activation::ReLU);
-    auto pool4 = x = graph->addConv("enc_conv4b", x, Activation::ReLU, PostOp::Pool);
+    x = graph->addConv(prefix + "enc_conv4a", x, Activation::ReLU);
+    auto pool4 = x = graph->addConv(prefix + "enc_conv4b", x, Activation::ReLU, PostOp::Pool);
 
-    x = graph->addConv("enc_conv5a", pool4, Activation::ReLU);
-    x = graph->addConv("enc_conv5b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConv(prefix + "enc_conv5a", pool4, Activation::ReLU);
+    x = graph->addConv(prefix + "enc_conv5b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv4a", x, pool3, Activation::ReLU);
-    x = graph->addConv("dec_conv4b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv4a", x, pool3, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv4b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv3a", x, pool2, Activation::ReLU);
-    x = graph->addConv("dec_conv3b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv3a", x, pool2, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv3b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv2a", x, pool1, Activation::ReLU);
-    x = graph->addConv("dec_conv2b", x, Activation::ReLU, PostOp::Upsample);
+    x = graph->addConcatConv(prefix + "dec_conv2a", x, pool1, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv2b", x, Activation::ReLU, PostOp::Upsample);
 
-    x = graph->addConcatConv("dec_conv1a", x, inputProcess, Activation::ReLU);
-    x = graph->addConv("dec_conv1b", x, Activation::ReLU);
-    x = graph->addConv("dec_conv1c", x, Activation::ReLU);
+    x = graph->addConcatConv(prefix + "dec_conv1a", x, inputProcess, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv1b", x, Activation::ReLU);
+    x = graph->addConv(prefix + "dec_conv1c", x, Activation::ReLU);
 
     return x;
   }
 
+  void UNetFilter::setAuxTile(int instanceID, const Ref<Image>& color, int h, int w, int tileH1, int tileW1)
+  {
+    auto& instance = instances[instanceID];
+
+    // Extend the input tile by the overlaps of the auxiliary prefiltering networks
+    const int auxH = max(h - auxTileOverlap, 0);
+    const int auxW = max(w - auxTileOverlap, 0);
+    const int auxTileH1 = min(h + tileH1 + auxTileOverlap, H) - auxH;
+    const int auxTileW1 = min(w + tileW1 + auxTileOverlap, W) - auxW;
+    const int alignOffsetH = auxTileH - round_up(auxTileH1, minTileAlignment); // align to the bottom in the tile buffer
+    const int alignOffsetW = auxTileW - round_up(auxTileW1, minTileAlignment); // align to the right in the tile buffer
+
+    auto setTile = [&](InputProcess* inputProcess, OutputProcess* outputProcess)
+    {
+      inputProcess->setTile(
+        auxH, auxW,
+        alignOffsetH, alignOffsetW,
+        auxTileH1, auxTileW1);
+
+      // Store only the input tile of the main network
+      outputProcess->setTile(
+        alignOffsetH + (h - auxH), alignOffsetW + (w - auxW),
+        0, 0,
+        tileH1, tileW1);
+    };
+
+    setTile(instance.albedoInputProcess.get(), instance.albedoOutputProcess.get());
+    setTile(instance.normalInputProcess.get(), instance.normalOutputProcess.get());
+
+    // The main network reads the input tile of the color image and the prefiltered tiles
+    instance.inputProcess->setSrc(color->newSubImage(h, w, tileH1, tileW1),
+                                  instance.albedoTile, instance.normalTile);
+  }
+
   // Tries to build the model without exceeding the specified amount of memory
   bool UNetFilter::buildModel(size_t maxMemoryByteSize)
   {
@@ -544,24 +1439,61 @@ OIDN_NAMESPACE_BEGIN
     if (normal) inputC += 3;
 
     // Create global operations (not part of any model instance or graph)
+    // Streamed HDR images require a manually specified input scale
+    const bool useAutoexposure = hdr && !streaming;
     Ref<Autoexposure> autoexposure;
-    if (hdr)
-      autoexposure = device->getEngine()->newAutoexposure(color->getDesc());
+    if (useAutoexposure)
+    {
+      // All images in the batch share the same autoexposure operation
+      ImageDesc colorDesc = color->getDesc();
+      colorDesc.height = H;
+      autoexposure = device->getEngine()->newAutoexposure(colorDesc);
+      autoexposure->setName("autoexposure");
+    }
 
     const bool snorm = directional || (!color && normal);
     TensorDims inputDims{inputC, tileH, tileW};
     size_t totalMemoryByteSize = 0;
 
-    // Create model instances for each subdevice
-    for (int instanceID = 0; instanceID < device->getNumSubdevices(); ++instanceID)
+    // The auxiliary prefiltering tiles cover the main tiles and their additional overlaps, and the
+    // prefiltered main tiles are stored in images
+    auxTileH = min(tileH + 2*auxTileOverlap, round_up(H, minTileAlignment));
+    auxTileW = min(tileW + 2*auxTileOverlap, round_up(W, minTileAlignment));
+    TensorDims auxInputDims{3, auxTileH, auxTileW};
+    ImageDesc auxTileDesc(Format::Float3, tileW, tileH);
+    const size_t auxTileByteSize = round_up(auxTileDesc.getByteSize(), memoryAlignment);
+
+    // Create model instances for each subdevice, and for pipelining on the same subdevice
+    for (int instanceID = 0; instanceID < int(instances.size()); ++instanceID)
     {
       auto& instance = instances[instanceID];
       auto& graph = instance.graph;
 
+      // Create the auxiliary prefiltering networks first, so their tensors can be reused by the
+      // main network
+      if (prefilterAux)
+      {
+        auto albedoInputProcess = graph->addInputProcess("alb.input", auxInputDims,
+                                                         albedoTransferFunc, false, false);
+        auto y = largeAlbedoModel ? addUNetLarge(graph, albedoInputProcess, "alb.")
+                                  : addUNet(graph, albedoInputProcess, "alb.");
+        instance.albedoInputProcess  = albedoInputProcess;
+        instance.albedoOutputProcess = graph->addOutputProcess("alb.output", y,
+                                                               albedoTransferFunc, false, false);
+
+        auto normalInputProcess = graph->addInputProcess("nrm.input", auxInputDims,
+                                                         normalTransferFunc, false, true);
+        y = largeNormalModel ? addUNetLarge(graph, normalInputProcess, "nrm.")
+                             : addUNet(graph, normalInputProcess, "nrm.");
+        instance.normalInputProcess  = normalInputProcess;
+        instance.normalOutputProcess = graph->addOutputProcess("nrm.output", y,
+                                                               normalTransferFunc, false, true);
+      }
+
       // Create the model graph
-      auto inputProcess = graph->addInputProcess("input", inputDims, transferFunc, hdr, snorm);
+      auto inputProcess = graph->addInputProcess("input", inputDims, instance.transferFunc, hdr, snorm);
       auto x = largeModel ? addUNetLarge(graph, inputProcess) : addUNet(graph, inputProcess);
-      auto outputProcess = graph->addOutputProcess("output", x, transferFunc, hdr, snorm);
+      auto outputProcess = graph->addOutputProcess("output", x, instance.transferFunc, hdr, snorm);
 
       // Check whether all operations in the graph are supported
       if (!graph->isSupported())
@@ -575,33 +1507,44 @@ OIDN_NAMESPACE_BEGIN
       size_t scratchByteSize = graphScratchByteSize;
 
       // Allocate scratch for global operations
-      if (instanceID == 0 && hdr)
+      if (instanceID == 0 && useAutoexposure)
         scratchByteSize = max(scratchByteSize, autoexposure->getScratchByteSize());
 
       scratchByteSize = round_up(scratchByteSize, memoryAlignment);
 
-      // If doing in-place _tiled_ filtering, allocate a temporary output image
-      ImageDesc outputTempDesc(output->getFormat(), W, H);
+      // Allocate the prefiltered auxiliary tile images
+      size_t auxTileByteOffset = SIZE_MAX;
+      if (prefilterAux)
+      {
+        auxTileByteOffset = scratchByteSize;
+        scratchByteSize += 2 * auxTileByteSize;
+      }
+
+      // If doing in-place _tiled_, batched or multi-region filtering, allocate a temporary output
+      // image, otherwise the overlaps of the later tiles would read already denoised pixels
+      ImageDesc outputTempDesc(output->getFormat(), W, output->getH());
       size_t outputTempByteOffset = SIZE_MAX;
-      if (instanceID == 0 && inplace && (tileCountH * tileCountW) > 1)
+      if (instanceID == 0 && needsOutputTemp())
       {
         outputTempByteOffset = scratchByteSize;
         scratchByteSize += round_up(outputTempDesc.getByteSize(), memoryAlignment);
       }
 
-      // If denoising in HDR mode, allocate a tensor for the autoexposure result
+      // If denoising in HDR mode, allocate a tensor for the autoexposure results
+      // Cached results must not be stored in the scratch, which is shared by other filters
       size_t autoexposureDstOffset = SIZE_MAX;
-      if (instanceID == 0 && hdr)
+      if (instanceID == 0 && useAutoexposure && !cacheAutoexposure)
       {
         autoexposureDstOffset = scratchByteSize;
-        scratchByteSize += round_up(sizeof(float), memoryAlignment);
+        scratchByteSize += round_up(batchSize * sizeof(float), memoryAlignment);
       }
 
       // Check the total memory usage
       if (instanceID == 0)
       {
+        const size_t instanceScratchByteSize = graphScratchByteSize + (prefilterAux ? 2 * auxTileByteSize : 0);
         totalMemoryByteSize = (scratchByteSize + graph->getPrivateByteSize()) +
-          (graphScratchByteSize + graph->getPrivateByteSize()) * (device->getNumSubdevices() - 1);
+          (instanceScratchByteSize + graph->getPrivateByteSize()) * (instances.size() - 1);
 
         if (totalMemoryByteSize > maxMemoryByteSize)
         {
@@ -610,16 +1553,28 @@ OIDN_NAMESPACE_BEGIN
         }
       }
 
-      // Allocate the scratch buffer
-      auto scratchArena = device->getSubdevice(instanceID)->newScratchArena(scratchByteSize);
+      // Allocate the scratch buffer, which is shared only by the filters executed in the same stream
+      // The pipelined instances of a subdevice are executed concurrently, so they need separate ones
+      const int subdeviceID = instanceID % device->getNumSubdevices();
+      const int pipelineSlot = instanceID / device->getNumSubdevices();
+      auto scratchArena = device->getSubdevice(subdeviceID)->newScratchArena(
+        scratchByteSize, "stream" + toString(streamID) + (pipelineSlot > 0 ? ".pipeline" : ""));
       auto scratch = scratchArena->newBuffer(scratchByteSize);
 
       // Set the scratch buffer for the graph and the global operations
       graph->setScratch(scratch);
-      if (instanceID == 0 && hdr)
+      if (instanceID == 0 && useAutoexposure)
       {
         autoexposure->setScratch(scratch);
-        autoexposure->setDst(makeRef<Record<float>>(scratch, autoexposureDstOffset));
+        Ref<Buffer> autoexposureDstBuffer = scratch;
+        if (cacheAutoexposure)
+        {
+          autoexposureDstBuffer = device->getEngine()->newBuffer(batchSize * sizeof(float), Storage::Device);
+          autoexposureDstOffset = 0;
+        }
+        for (int b = 0; b < batchSize; ++b)
+          autoexposureDsts.push_back(makeRef<Record<float>>(autoexposureDstBuffer, autoexposureDstOffset + b * sizeof(float)));
+        autoexposure->setDst(autoexposureDsts[0]);
       }
 
       // Finalize the network
@@ -629,18 +1584,28 @@ OIDN_NAMESPACE_BEGIN
       if (instanceID == 0 && outputTempByteOffset < SIZE_MAX)
         outputTemp = scratch->newImage(outputTempDesc, outputTempByteOffset);
 
+      // Create the prefiltered auxiliary tile images
+      if (prefilterAux)
+      {
+        instance.albedoTile = scratch->newImage(auxTileDesc, auxTileByteOffset);
+        instance.normalTile = scratch->newImage(auxTileDesc, auxTileByteOffset + auxTileByteSize);
+        instance.albedoOutputProcess->setDst(instance.albedoTile);
+        instance.normalOutputProcess->setDst(instance.normalTile);
+      }
+
       instance.inputProcess  = inputProcess;
       instance.outputProcess = outputProcess;
     }
 
     // Finalize the global operations
-    if (hdr)
+    if (useAutoexposure)
       autoexposure->finalize();
     this->autoexposure = autoexposure;
 
     if (outputTemp)
     {
       imageCopy = device->getEngine()->newImageCopy();
+      imageCopy->setName("output_copy");
       imageCopy->setSrc(outputTemp);
       imageCopy->finalize();
     }
@@ -659,9 +1624,17 @@ OIDN_NAMESPACE_BEGIN
       instance.graph->clear();
       instance.inputProcess.reset();
       instance.outputProcess.reset();
+      instance.albedoInputProcess.reset();
+      instance.albedoOutputProcess.reset();
+      instance.albedoTile.reset();
+      instance.normalInputProcess.reset();
+      instance.normalOutputProcess.reset();
+      instance.normalTile.reset();
     }
 
     autoexposure.reset();
+    autoexposureDsts.clear();
+    autoexposureCached = false;
     imageCopy.reset();
     outputTemp.reset();
   }
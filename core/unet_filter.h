@@ -8,6 +8,8 @@
 #include "color.h"
 #include "autoexposure.h"
 #include "image_copy.h"
+#include <functional>
+#include <mutex>
 
 OIDN_NAMESPACE_BEGIN
 
@@ -37,12 +39,17 @@ OIDN_NAMESPACE_BEGIN
     static constexpr int minTileAlignment     = 16;  // required spatial alignment in pixels (padding may be necessary)
 
     static constexpr int defaultMaxTileSize   = 2160*2160; // default maximum number of pixels per tile
+    static constexpr int minTunedTileSize     = 256; // minimum tile size in pixels considered by the autotuner
+    static constexpr int maxTunedTileSizes    = 6;   // maximum number of tile sizes measured by the autotuner
+    static constexpr int coverageBlockSize    = 16;  // size of the blocks in which the coverage is tracked
 
     // Images
     Ref<Image> color;
     Ref<Image> albedo;
     Ref<Image> normal;
     Ref<Image> output;
+    Ref<Image> coverage; // optional, pixels with zero coverage are empty and their tiles may be skipped
+    bool coverageDirty = true; // the covered blocks must be updated from the coverage image
 
     // Options
     static constexpr Quality defaultQuality = Quality::High;
@@ -51,8 +58,20 @@ OIDN_NAMESPACE_BEGIN
     bool srgb = false;
     bool directional = false;
     float inputScale = std::numeric_limits<float>::quiet_NaN();
+    bool temporalAutoexposure = false;  // use the smoothed input scale of the previous execution
+    float autoexposureSmoothing = 0.5f; // weight of the previous input scale in temporal autoexposure
+    bool cacheAutoexposure = false;     // reuse the autoexposure results until the color image is set again
+    bool autoexposureCached = false;    // are the cached autoexposure results valid for the color image?
     bool cleanAux = false;
+    bool prefilterAux = false; // prefilter the noisy auxiliary images in the same pass
     int maxMemoryMB = -1;     // maximum memory usage limit in MBs, disabled if < 0
+    int batchSize = 1;        // number of images stacked vertically in each image parameter
+    bool autotune = false;    // select the fastest tile size by measuring a few candidates
+    int roiX = 0;             // region of interest in each image, the full image if the size is zero
+    int roiY = 0;
+    int roiWidth = 0;
+    int roiHeight = 0;
+    Data dirtyRects;          // optional (x, y, width, height) rectangles to denoise inside the ROI
     int prevMaxMemoryMB = -1; // maximum memory usage limit in MBs from the previous commit
 
     struct Model
@@ -85,17 +104,57 @@ OIDN_NAMESPACE_BEGIN
     Data userWeightsBlob;
 
   private:
+    // Rectangular region of an image
+    struct Region
+    {
+      int h, w; // position
+      int H, W; // size
+    };
+
+    // Tile of a region to denoise
+    struct TileDesc
+    {
+      int h, w;                       // input tile position (including overlaps)
+      int H1, W1;                     // input tile size (including overlaps)
+      int alignOffsetH, alignOffsetW; // offset of the input tile in the tile buffer
+      int outputH, outputW;           // output tile position (clipped to the region)
+      int H2, W2;                     // output tile size
+    };
+
     void init();
     void cleanup();
     void checkParams();
     Data getWeights();
-    Ref<Op> addUNet(const Ref<Graph>& graph, const Ref<Op>& inputProcess);
-    Ref<Op> addUNetLarge(const Ref<Graph>& graph, const Ref<Op>& inputProcess);
+    Data getWeights(const Model& model);
+    Ref<Image> getBatchImage(const Ref<Image>& image, int b) const;
+    std::vector<Region> getRegions() const;
+    bool isFullRegion(const std::vector<Region>& regions) const;
+    bool needsOutputTemp() const;
+    void forEachTile(const std::vector<Region>& regions, int b,
+                     const std::function<void(const TileDesc&)>& func) const;
+    void updateCoverageBlocks();
+    bool isCovered(int b, int h, int w, int regionH, int regionW) const;
+    Ref<Op> addUNet(const Ref<Graph>& graph, const Ref<Op>& inputProcess,
+                    const std::string& prefix = "");
+    Ref<Op> addUNetLarge(const Ref<Graph>& graph, const Ref<Op>& inputProcess,
+                         const std::string& prefix = "");
+    void setAuxTile(int instanceID, const Ref<Image>& color, int h, int w, int tileH1, int tileW1);
     bool buildModel(size_t maxMemoryByteSize = std::numeric_limits<size_t>::max());
+    bool splitTiles(int minTileH, int minTileW);
+    int getTileCount(int size, int tileSize, int tilePad) const;
+    void tuneTileSize(const Data& weightsBlob, size_t maxMemoryByteSize);
+    double measureTileTime();
+    void submitOp(const Ref<Op>& op, const Ref<Progress>& progress);
+    void submitAutoexposure(const Ref<Progress>& progress);
+    void submitTemporalAutoexposureUpdate();
+    void executeStreaming();
+    void submitPipelinedTile(const Ref<Graph>& graph, const Ref<Progress>& progress);
+    void flushPipeline(const Ref<Progress>& progress);
+    void reportProfile();
     void resetModel();
 
     // Image dimensions
-    int H = 0;             // image height
+    int H = 0;             // image height (of a single image in the batch)
     int W = 0;             // image width
     int tileH = 0;         // tile height
     int tileW = 0;         // tile width
@@ -105,24 +164,74 @@ OIDN_NAMESPACE_BEGIN
     int tileCountW = 1;    // number of tiles in W dimension
     int tileOverlap = 0;   // device-dependent spatial overlap between tiles in pixels
     int tileAlignment = 1; // device-dependent spatial tile offset alignment in pixels
+    int auxTileH = 0;      // auxiliary prefiltering tile height (including its own overlaps)
+    int auxTileW = 0;      // auxiliary prefiltering tile width
+    int auxTileOverlap = 0; // spatial overlap of the auxiliary prefiltering tiles in pixels
     bool inplace = false;  // indicates whether input and output buffers overlap
 
+    // Covered blocks of the images in the batch, for skipping the empty tiles
+    std::vector<bool> coverageBlocks;
+    int coverageBlocksH = 0;
+    int coverageBlocksW = 0;
+
     // Per-engine model instance
     struct Instance
     {
       Ref<Graph> graph;
+      std::shared_ptr<TransferFunction> transferFunc; // separate input scale for each pipelined tile
       Ref<InputProcess> inputProcess;
       Ref<OutputProcess> outputProcess;
+
+      // Auxiliary image prefiltering, with the results stored in tile images in the scratch
+      Ref<InputProcess> albedoInputProcess;
+      Ref<OutputProcess> albedoOutputProcess;
+      Ref<Image> albedoTile;
+      Ref<InputProcess> normalInputProcess;
+      Ref<OutputProcess> normalOutputProcess;
+      Ref<Image> normalTile;
     };
 
     // Model
-    std::vector<Instance> instances;
-    std::shared_ptr<TransferFunction> transferFunc;
+    std::vector<Instance> instances;  // instances of each engine are interleaved if pipelined
+    bool pipelined = false;           // are consecutive tiles denoised by two instances per engine?
+    bool weightCacheLoaded = false;   // are the reordered weights mapped from the on-disk cache?
+    std::shared_ptr<TransferFunction> albedoTransferFunc; // for auxiliary prefiltering
+    std::shared_ptr<TransferFunction> normalTransferFunc;
     Ref<Autoexposure> autoexposure;
+    std::vector<Ref<Record<float>>> autoexposureDsts; // autoexposure result for each image in the batch
+
+    // Graph of the previous tile in the pipeline, whose second half has not been submitted yet
+    Ref<Graph> pipelinedGraph;
+
+    // Temporal autoexposure state, which is updated asynchronously after each execution
+    struct TemporalAutoexposureState
+    {
+      std::vector<float> results; // autoexposure results of the last execution read from the device
+      std::vector<float> scales;  // smoothed input scales (NaN if not available yet)
+      std::mutex mutex;           // protects the smoothed input scales
+
+      explicit TemporalAutoexposureState(int batchSize)
+        : results(batchSize, 1.f),
+          scales(batchSize, std::numeric_limits<float>::quiet_NaN()) {}
+    };
+
+    std::shared_ptr<TemporalAutoexposureState> temporalAutoexposureState;
+
     // In-place tiled filtering
     Ref<ImageCopy> imageCopy;
     Ref<Image> outputTemp;
-    bool largeModel = false; // is UNetLarge?
+    std::shared_ptr<Profiler> profiler; // optional per-operation profiler
+
+    // Streamed images are processed in bands of rows stored in host memory
+    bool streaming = false;
+    Ref<Image> colorBand;
+    Ref<Image> albedoBand;
+    Ref<Image> normalBand;
+    Ref<Image> outputBand;
+
+    bool largeModel = false;       // is UNetLarge?
+    bool largeAlbedoModel = false; // is the auxiliary albedo prefiltering model UNetLarge?
+    bool largeNormalModel = false; // is the auxiliary normal prefiltering model UNetLarge?
   };
 
 OIDN_NAMESPACE_END
@@ -34,4 +34,12 @@ OIDN_NAMESPACE_BEGIN
     updateDst();
   }
 
+  OpCost Upsample::getCost() const
+  {
+    OpCost cost;
+    cost.bytesRead    = srcDesc.getByteSize();
+    cost.bytesWritten = dstDesc.getByteSize();
+    return cost;
+  }
+
 OIDN_NAMESPACE_END
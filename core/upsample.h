@@ -25,6 +25,9 @@ OIDN_NAMESPACE_BEGIN
     void setSrc(const Ref<Tensor>& src);
     void setDst(const Ref<Tensor>& dst);
 
+    const char* getTypeName() const override { return "upsample"; }
+    OpCost getCost() const override;
+
   protected:
     virtual void updateSrc() {}
     virtual void updateDst() {}
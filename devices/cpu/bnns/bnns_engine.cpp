@@ -7,8 +7,9 @@
 
 OIDN_NAMESPACE_BEGIN
 
-  BNNSEngine::BNNSEngine(CPUDevice* device, int numThreads)
-    : CPUEngine(device, numThreads)
+  BNNSEngine::BNNSEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode,
+                         tbb::task_arena* externalArena)
+    : CPUEngine(device, numThreads, threadIndexOffset, numaNode, externalArena)
   {}
 
   Ref<Conv> BNNSEngine::newConv(const ConvDesc& desc)
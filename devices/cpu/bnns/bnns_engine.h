@@ -10,7 +10,8 @@ OIDN_NAMESPACE_BEGIN
   class BNNSEngine final : public CPUEngine
   {
   public:
-    BNNSEngine(CPUDevice* device, int numThreads);
+    BNNSEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode = -1,
+               tbb::task_arena* externalArena = nullptr);
 
     // Ops
     Ref<Conv> newConv(const ConvDesc& desc) override;
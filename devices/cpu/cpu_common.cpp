@@ -14,26 +14,7 @@ OIDN_NAMESPACE_BEGIN
     acc.ptr = reinterpret_cast<uint8_t*>(ptr);
     acc.hByteStride = hByteStride;
     acc.wByteStride = wByteStride;
-
-    switch (getDataType())
-    {
-    case DataType::Void:
-      acc.dataType = ispc::DataType_Void;
-      break;
-    /*
-    case DataType::UInt8:
-      acc.dataType = ispc::DataType_UInt8;
-      break;
-    */
-    case DataType::Float16:
-      acc.dataType = ispc::DataType_Float16;
-      break;
-    case DataType::Float32:
-      acc.dataType = ispc::DataType_Float32;
-      break;
-    default:
-      throw std::logic_error("unsupported data type");
-    }
+    acc.dataType = toISPC(getDataType());
 
     acc.C = getC();
     if (acc.C > 3)
@@ -49,8 +30,12 @@ OIDN_NAMESPACE_BEGIN
     if (getRank() != 3 || layout == TensorLayout::hwc)
       throw std::logic_error("incompatible tensor accessor");
 
+    if (dataType != DataType::Float32 && dataType != DataType::Float16)
+      throw std::logic_error("unsupported tensor accessor data type");
+
     ispc::TensorAccessor3D acc;
     acc.ptr = static_cast<uint8_t*>(getPtr());
+    acc.dataType = toISPC(dataType);
     acc.C = getPaddedC();
     acc.H = getH();
     acc.W = getW();
@@ -72,6 +57,7 @@ OIDN_NAMESPACE_BEGIN
 
     ispc::TensorAccessor1D acc;
     acc.ptr = static_cast<uint8_t*>(getPtr());
+    acc.dataType = toISPC(dataType);
     acc.X = getPaddedX();
     return acc;
   }
@@ -83,6 +69,7 @@ OIDN_NAMESPACE_BEGIN
 
     ispc::TensorAccessor4D acc;
     acc.ptr = static_cast<uint8_t*>(getPtr());
+    acc.dataType = toISPC(dataType);
 
     acc.O = getPaddedO();
     acc.I = getPaddedI();
@@ -101,6 +88,20 @@ OIDN_NAMESPACE_BEGIN
   }
 #endif
 
+  ispc::DataType toISPC(DataType dataType)
+  {
+    switch (dataType)
+    {
+    case DataType::Void:    return ispc::DataType_Void;
+    //case DataType::UInt8: return ispc::DataType_UInt8;
+    case DataType::Int8:    return ispc::DataType_Int8;
+    case DataType::Float16: return ispc::DataType_Float16;
+    case DataType::Float32: return ispc::DataType_Float32;
+    default:
+      throw std::logic_error("unsupported data type");
+    }
+  }
+
   ispc::Tile toISPC(const Tile& tile)
   {
     ispc::Tile res;
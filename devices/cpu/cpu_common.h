@@ -12,6 +12,7 @@
 
 OIDN_NAMESPACE_BEGIN
 
+  ispc::DataType toISPC(DataType dataType);
   ispc::Tile toISPC(const Tile& tile);
   ispc::TransferFunction toISPC(const TransferFunction& tf);
 
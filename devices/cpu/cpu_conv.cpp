@@ -12,21 +12,22 @@ OIDN_NAMESPACE_BEGIN
       engine(engine)
   {
     if ((srcDesc.layout != TensorLayout::Chw8c &&
-         srcDesc.layout != TensorLayout::Chw16c) || srcDesc.dataType != DataType::Float32)
+         srcDesc.layout != TensorLayout::Chw16c) ||
+        (srcDesc.dataType != DataType::Float32 && srcDesc.dataType != DataType::Float16))
       throw std::invalid_argument("unsupported convolution source layout/data type");
     if (weightDesc.getW() != 3 || weightDesc.getH() != 3)
       throw std::invalid_argument("unsupported convolution kernel size");
     if ((weightDesc.layout != TensorLayout::IOhw8i8o &&
          weightDesc.layout != TensorLayout::IOhw16i16o) || weightDesc.dataType != DataType::Float32)
       throw std::invalid_argument("unsupported convolution weight layout/data type");
-    if (biasDesc.layout != TensorLayout::x || biasDesc.dataType != DataType::Float32)
+    if (biasDesc.layout != TensorLayout::x || biasDesc.dataType != srcDesc.dataType)
       throw std::invalid_argument("unsupported convolution bias layout/data type");
 
     const int blockC = getTensorLayoutInfo(dstDesc.layout).blockC;
     const int IC = srcDesc.getPaddedC();
     const int OC = dstDesc.getPaddedC();
-    const int OH = dstDesc.getH();
-    const int OW = dstDesc.getW();
+    const int OH = srcDesc.getH(); // convolution output height (before the post-op)
+    const int OW = srcDesc.getW(); // convolution output width  (before the post-op)
 
     const int OCB = OC / blockC;
     blockOCB = min(OCB, ispc::CPUConvKernel_getMaxBlockOCB());
@@ -36,24 +37,75 @@ OIDN_NAMESPACE_BEGIN
     OCBB = OCB / blockOCB;
     blockOW = ispc::CPUConvKernel_getBlockOW(blockOCB);
 
-    // Split the output width into tiles to fit into the L2 cache
-    const size_t cacheSize = 512 * 1024; // FIXME: query actual size but this also works well
+    // Use int8 weights for the wide layers if quantization is allowed, which reduces the memory
+    // bandwidth and cache footprint of the weights by 4x. The activations and accumulators remain
+    // in single precision, so only tensors in this format are supported.
+    if (quantized && srcDesc.dataType == DataType::Float32 && IC >= 32 && OC >= 32)
+      int8Weight = true;
 
-    const int tileOW = max(
-      static_cast<int>((cacheSize - weightDesc.getByteSize() - biasDesc.getByteSize()) /
-                       (IC * getDataTypeSize(srcDesc.dataType)  * weightDesc.getH() +
-                        OC * getDataTypeSize(dstDesc.dataType)) - weightDesc.getW() + 1),
-      1);
+    // Otherwise use Winograd convolution for the wide layers if fast math is enabled, which requires
+    // much fewer multiplications but is slightly less accurate. F(4x4, 3x3) saves more than
+    // F(2x2, 3x3) but wastes more work on the partial tiles at the borders, so it's used only for
+    // larger sizes. The tile size can be also forced or Winograd disabled (e.g. for testing).
+    else if (fastMath && IC >= 32 && OC >= 32 && min(OH, OW) >= 8)
+    {
+      winogradM = engine->getWinogradM();
+      if (winogradM < 0)
+        winogradM = (min(OH, OW) >= 32) ? 4 : 2;
+      else if (winogradM != 0 && winogradM != 2 && winogradM != 4)
+        throw std::invalid_argument("unsupported Winograd output tile size");
+    }
+
+    // Split the output width into tiles to fit into the L2 cache of a core
+    const size_t cacheSize = engine->getCacheInfo().l2Size;
+
+    int workH;  // number of rows of work items
+    int workW;  // width of a row of work items
+    int tileOW; // max width of the OW tiles
+    if (winogradM)
+    {
+      // Each work item computes a row of Winograd tiles, whose accumulated products should fit into
+      // half of the L2 cache
+      const int A = winogradM + 2;
+      workH = ceil_div(OH, winogradM);
+      workW = ceil_div(OW, winogradM);
+      tileOW = max(static_cast<int>(cacheSize / 2 / (size_t(blockOCB) * A * A * blockC * sizeof(float))),
+                   blockOW);
+    }
+    else
+    {
+      // With pooling each work item computes 2 convolution rows
+      workH = (postOp == PostOp::Pool) ? OH / 2 : OH;
+      workW = OW;
+
+      // The work items of the output channel blocks of a tile share the source rows and ideally
+      // the weights too. For very wide layers the weights would take up most of the cache, so
+      // only the weights of the output channel blocks of a single work item are kept, which are
+      // streamed one input channel block at a time by the kernel.
+      size_t weightByteSize = getWeightDesc().getByteSize() + biasDesc.getByteSize();
+      int cachedOC = OC;
+      if (weightByteSize > cacheSize / 2)
+      {
+        sharedWeights = false;
+        weightByteSize /= OCBB;
+        cachedOC = blockOCB * blockC;
+      }
+
+      const size_t colByteSize = size_t(IC) * getDataTypeSize(srcDesc.dataType) * weightDesc.getH() +
+                                 size_t(cachedOC) * getDataTypeSize(dstDesc.dataType);
+      const size_t tileByteSize = cacheSize - min(weightByteSize, cacheSize / 2);
+      tileOW = max(static_cast<int>(tileByteSize / colByteSize) - weightDesc.getW() + 1, 1);
+    }
 
-    const int maxOWT = max(OW / (2*blockOW), 1); // max number of OW tiles
-    OWT = min(ceil_div(OW, tileOW), maxOWT);     // number of OW tiles
+    const int maxOWT = max(workW / (2*blockOW), 1); // max number of OW tiles
+    OWT = min(ceil_div(workW, tileOW), maxOWT);     // number of OW tiles
 
     // Tweak the number of OW tiles to maximize threading efficiency
     const int numThreads = engine->getNumThreads();
     double bestThreadEff = 0;
     for (int curOWT = OWT; curOWT < maxOWT; ++curOWT)
     {
-      const size_t N = size_t(OCBB) * OH * curOWT; // work amount
+      const size_t N = size_t(OCBB) * workH * curOWT; // work amount
       const double threadEff = 1. - double(N % numThreads) / N;
       if (threadEff > bestThreadEff)
       {
@@ -63,41 +115,373 @@ OIDN_NAMESPACE_BEGIN
           break;
       }
     }
+
+    maxTileOW = 0;
+    for (int owt = 0; owt < OWT; ++owt)
+    {
+      int owBegin, owEnd;
+      getTileOW(owt, owBegin, owEnd);
+      maxTileOW = max(maxTileOW, owEnd - owBegin);
+    }
+
+    if (winogradM)
+    {
+      // Winograd convolution transforms a block of input tiles and accumulates the products for
+      // all tiles of the work item in a temporary buffer
+      const int A = winogradM + 2;
+      tempByteSize = round_up(size_t(A) * A * (blockOW + blockOCB * maxTileOW) * blockC * sizeof(float),
+                              memoryAlignment);
+    }
+    else if (postOp != PostOp::None)
+    {
+      // Fused post-ops accumulate in a temporary buffer instead of the destination
+      const int tempH = (postOp == PostOp::Pool) ? 2 : 1;
+      tempByteSize = round_up(size_t(tempH) * blockOCB * maxTileOW * blockC * getDataTypeSize(dstDesc.dataType),
+                              memoryAlignment);
+    }
+  }
+
+  TensorDesc CPUConv::getWeightDesc() const
+  {
+    if (int8Weight)
+      return {weightDesc.dims, weightDesc.paddedDims, weightDesc.layout, DataType::Int8};
+
+    if (!winogradM)
+      return weightDesc;
+
+    // The weights transformed to the Winograd domain have the size of the input tiles
+    const int A = winogradM + 2;
+    return {{weightDesc.getO(),       weightDesc.getI(),       A, A},
+            {weightDesc.getPaddedO(), weightDesc.getPaddedI(), A, A},
+            weightDesc.layout, weightDesc.dataType};
+  }
+
+  size_t CPUConv::getScratchByteSize()
+  {
+    return tempByteSize * engine->getNumThreads();
+  }
+
+  void CPUConv::setScratch(const Ref<Buffer>& scratch)
+  {
+    if (scratch->getByteSize() < getScratchByteSize())
+      throw std::invalid_argument("convolution scratch buffer is too small");
+    this->scratch = scratch;
+  }
+
+  bool CPUConv::fuseInputProcess(const Ref<InputProcess>& inputProcess)
+  {
+    // Only direct convolutions without post-ops are supported, which compute single rows
+    if (!engine->isProcessFusionEnabled() || postOp != PostOp::None || winogradM || this->inputProcess)
+      return false;
+
+    auto cpuInputProcess = dynamicRefCast<CPUInputProcess>(inputProcess);
+    if (!cpuInputProcess || cpuInputProcess->isFused())
+      return false;
+
+    // Each work item processes a band of source rows, which is then convolved while still in the
+    // cache, so the band should fit into a quarter of the L2 cache, but there should be enough
+    // bands to keep all threads busy
+    const int H = srcDesc.getH();
+    const size_t rowByteSize = srcDesc.getByteSize() / H;
+    const size_t cacheSize = engine->getCacheInfo().l2Size;
+    bandH = max(static_cast<int>(cacheSize / 4 / rowByteSize), 4);
+    bandH = max(min(bandH, ceil_div(H, 2 * engine->getNumThreads())), 1);
+
+    cpuInputProcess->setFused();
+    this->inputProcess = cpuInputProcess;
+    return true;
+  }
+
+  bool CPUConv::fuseOutputProcess(const Ref<OutputProcess>& outputProcess)
+  {
+    // Only direct convolutions without post-ops are supported, whose output channels to process
+    // fit into a single channel block
+    const int blockC = getTensorLayoutInfo(dstDesc.layout).blockC;
+    if (!engine->isProcessFusionEnabled() || postOp != PostOp::None || winogradM || inputProcess ||
+        this->outputProcess || dstDesc.getC() > blockC)
+      return false;
+
+    auto cpuOutputProcess = dynamicRefCast<CPUOutputProcess>(outputProcess);
+    if (!cpuOutputProcess || cpuOutputProcess->isFused())
+      return false;
+
+    // Each work item computes the first output channel block of a row into a temporary buffer,
+    // which is then processed and written to the output image
+    tempByteSize = round_up(size_t(dstDesc.getW()) * blockC * getDataTypeSize(dstDesc.dataType),
+                            memoryAlignment);
+
+    cpuOutputProcess->setFused();
+    this->outputProcess = cpuOutputProcess;
+    return true;
+  }
+
+  void CPUConv::finalize()
+  {
+    if (engine->getDevice()->isVerbose(2))
+    {
+      std::cout << "Conv " << getName() << ": ";
+      if (winogradM)
+        std::cout << "Winograd F(" << winogradM << "x" << winogradM << ", 3x3)";
+      else
+        std::cout << "direct" << (int8Weight ? " int8" : "");
+      std::cout << ", blockOCB=" << blockOCB << ", blockOW=" << blockOW
+                << ", OWT=" << OWT << ", tileOW=" << maxTileOW;
+      if (!winogradM)
+        std::cout << ", cached weights: " << (sharedWeights ? "all" : "work item");
+      if (inputProcess)
+        std::cout << ", fused input process: bandH=" << bandH;
+      if (outputProcess)
+        std::cout << ", fused output process";
+      std::cout << std::endl;
+    }
+  }
+
+  const char* CPUConv::getTypeName() const
+  {
+    // The fused processing is profiled as part of the convolution
+    if (inputProcess)
+      return "input_process_conv";
+    if (outputProcess)
+      return "conv_output_process";
+    return Conv::getTypeName();
+  }
+
+  OpCost CPUConv::getCost() const
+  {
+    OpCost cost = Conv::getCost();
+    if (inputProcess)
+      cost += inputProcess->InputProcess::getCost();
+    if (outputProcess)
+    {
+      // The destination tensor is neither written nor read by the output processing
+      const OpCost outputCost = outputProcess->OutputProcess::getCost();
+      cost.bytesWritten = outputCost.bytesWritten;
+      cost.flops += outputCost.flops;
+    }
+    return cost;
+  }
+
+  void CPUConv::getTileOW(int owt, int& owBegin, int& owEnd) const
+  {
+    const int OW = srcDesc.getW();
+
+    // For Winograd convolution the tiles are ranges of Winograd tile columns
+    if (winogradM)
+    {
+      const int TW = ceil_div(OW, winogradM);
+      owBegin = owt   > 0   ? (owt     * TW) / (OWT*blockOW) * blockOW : 0;
+      owEnd   = owt+1 < OWT ? ((owt+1) * TW) / (OWT*blockOW) * blockOW : TW;
+      return;
+    }
+
+    constexpr int PW = 1; // KW = 3
+    const int owr = OWT * (blockOW - PW - 1);
+    owBegin = owt   > 0   ? (owt     * OW + owr) / (OWT*blockOW) * blockOW + PW : 0;
+    owEnd   = owt+1 < OWT ? ((owt+1) * OW + owr) / (OWT*blockOW) * blockOW + PW : OW;
+
+    // Pooling requires an even range (OW is even)
+    if (postOp == PostOp::Pool)
+    {
+      owBegin &= ~1;
+      owEnd   &= ~1;
+    }
   }
 
   void CPUConv::submitKernels(const Ref<CancellationToken>& ct)
   {
-    if (!src || !dst)
+    if (!src || (!dst && !outputProcess))
       throw std::logic_error("conving source/destination not set");
 
+    if ((postOp != PostOp::None || winogradM || outputProcess) && (!scratch || scratch->getByteSize() < getScratchByteSize()))
+      throw std::logic_error("convolution scratch not set");
+    if (int8Weight && !weightScale)
+      throw std::logic_error("convolution weight scale not set");
+
     ispc::CPUConvKernel kernel;
     kernel.src    = *src;
     kernel.weight = *weight;
     kernel.bias   = *bias;
     kernel.dst    = *dst;
     kernel.relu   = activation == Activation::ReLU;
+    if (int8Weight)
+      kernel.weightScale = *weightScale;
+
+    if (inputProcess)
+    {
+      submitFusedInputKernels(ct);
+      return;
+    }
+    if (outputProcess)
+    {
+      submitFusedOutputKernels(ct);
+      return;
+    }
+
+    switch (postOp)
+    {
+    case PostOp::Pool:     kernel.postOp = ispc::CPUConvPostOp_Pool;     break;
+    case PostOp::Upsample: kernel.postOp = ispc::CPUConvPostOp_Upsample; break;
+    default:               kernel.postOp = ispc::CPUConvPostOp_None;     break;
+    }
+
+    uint8_t* tempPtr = scratch ? static_cast<uint8_t*>(scratch->getPtr()) : nullptr;
 
     engine->submitFunc([=]
     {
-      const int OH = kernel.dst.H;
-      const int OW = kernel.dst.W;
-      const size_t N = size_t(OCBB) * OH * OWT;
+      int workH;
+      if (winogradM)
+        workH = ceil_div(kernel.src.H, winogradM);
+      else
+        workH = (kernel.postOp == ispc::CPUConvPostOp_Pool) ? kernel.src.H / 2 : kernel.src.H;
+      const size_t N = size_t(OCBB) * workH * OWT;
 
       parallel_for(N, [&](size_t i)
       {
         const size_t j = i / OCBB;
         const int ocbb = int(i % OCBB);
-        const int oh   = int(j % OH);
-        const int owt  = int(j / OH);
+        const int oh   = int(j % workH);
+        const int owt  = int(j / workH);
+
+        int owBegin, owEnd;
+        getTileOW(owt, owBegin, owEnd);
+
+        uint8_t* threadTempPtr = nullptr;
+        if (tempPtr)
+          threadTempPtr = tempPtr + size_t(tbb::this_task_arena::current_thread_index()) * tempByteSize;
+
+        if (winogradM)
+          ispc::CPUConvKernel_runWinograd(&kernel, winogradM, blockOCB, ocbb * blockOCB, oh, owBegin, owEnd, threadTempPtr);
+        else
+          ispc::CPUConvKernel_run(&kernel, blockOCB, ocbb * blockOCB, oh, owBegin, owEnd, threadTempPtr);
+      });
+    }, ct);
+  }
+
+  void CPUConv::submitFusedInputKernels(const Ref<CancellationToken>& ct)
+  {
+    ispc::CPUInputProcessKernel inputKernel = inputProcess->getKernel();
+
+    ispc::CPUConvKernel kernel;
+    kernel.src    = *src;
+    kernel.weight = *weight;
+    kernel.bias   = *bias;
+    kernel.dst    = *dst;
+    kernel.relu   = activation == Activation::ReLU;
+    kernel.postOp = ispc::CPUConvPostOp_None;
+    if (int8Weight)
+      kernel.weightScale = *weightScale;
+
+    engine->submitFunc([=]
+    {
+      const int H = kernel.src.H;
+      const int numBands = ceil_div(H, bandH);
+
+      // Convolves the rows of a band for all output channel blocks and OW tiles
+      auto runConv = [&](int ohBegin, int ohEnd)
+      {
+        for (int owt = 0; owt < OWT; ++owt)
+        {
+          int owBegin, owEnd;
+          getTileOW(owt, owBegin, owEnd);
+
+          for (int ocbb = 0; ocbb < OCBB; ++ocbb)
+          {
+            for (int oh = ohBegin; oh < ohEnd; ++oh)
+              ispc::CPUConvKernel_run(&kernel, blockOCB, ocbb * blockOCB, oh, owBegin, owEnd, nullptr);
+          }
+        }
+      };
+
+      // Process the source rows of each band and convolve the inner rows of the band, which do not
+      // depend on the rows of the neighboring bands, while the processed rows are in the cache.
+      // The source tensor is written only once, as it may be used by later operations too.
+      parallel_for(numBands, [&](int band)
+      {
+        const int hBegin = band * bandH;
+        const int hEnd   = min(hBegin + bandH, H);
+        for (int h = hBegin; h < hEnd; ++h)
+          ispc::CPUInputProcessKernel_run(&inputKernel, h);
+
+        const int ohBegin = hBegin > 0 ? hBegin + 1 : hBegin;
+        const int ohEnd   = hEnd   < H ? hEnd   - 1 : hEnd;
+        if (ohBegin < ohEnd)
+          runConv(ohBegin, ohEnd);
+      });
+
+      // Convolve the border rows of the bands after all source rows have been processed
+      parallel_for(numBands, [&](int band)
+      {
+        const int hBegin = band * bandH;
+        const int hEnd   = min(hBegin + bandH, H);
+        const int ohBegin = hBegin > 0 ? hBegin + 1 : hBegin;
+        const int ohEnd   = hEnd   < H ? hEnd   - 1 : hEnd;
+
+        if (ohBegin >= ohEnd)
+          runConv(hBegin, hEnd); // the band has no inner rows
+        else
+        {
+          runConv(hBegin, ohBegin);
+          runConv(ohEnd, hEnd);
+        }
+      });
+    }, ct);
+  }
+
+  void CPUConv::submitFusedOutputKernels(const Ref<CancellationToken>& ct)
+  {
+    ispc::CPUOutputProcessKernel outputKernel = outputProcess->getKernel();
+
+    // Each output row is computed into a temporary single-row tensor, which is the source of the
+    // output processing of that row
+    ispc::TensorAccessor3D rowAcc;
+    rowAcc.ptr = nullptr;
+    rowAcc.dataType = toISPC(dstDesc.dataType);
+    rowAcc.C = getTensorLayoutInfo(dstDesc.layout).blockC;
+    rowAcc.H = 1;
+    rowAcc.W = dstDesc.getW();
+    rowAcc.hByteStride = size_t(rowAcc.W) * rowAcc.C * getDataTypeSize(dstDesc.dataType);
+    rowAcc.CByteStride = rowAcc.hByteStride;
+
+    ispc::CPUConvKernel kernel;
+    kernel.src    = *src;
+    kernel.weight = *weight;
+    kernel.bias   = *bias;
+    kernel.relu   = activation == Activation::ReLU;
+    kernel.postOp = ispc::CPUConvPostOp_None;
+    if (int8Weight)
+      kernel.weightScale = *weightScale;
+
+    // The convolution writes destination row oh to row oh of its destination, so it gets a view of
+    // the row tensor with a zero row stride, which maps all rows to the single row
+    kernel.dst = rowAcc;
+    kernel.dst.hByteStride = 0;
+
+    uint8_t* tempPtr = static_cast<uint8_t*>(scratch->getPtr());
+
+    engine->submitFunc([=]
+    {
+      const ispc::Tile& tile = outputKernel.tile;
+
+      // Compute only the rows and columns of the tile
+      parallel_for(tile.H, [&](int h)
+      {
+        uint8_t* rowPtr = tempPtr + size_t(tbb::this_task_arena::current_thread_index()) * tempByteSize;
 
-        constexpr int PW = 1; // KW = 3
-        const int owr = OWT * (blockOW - PW - 1);
-        const int owBegin = owt   > 0   ? (owt     * OW + owr) / (OWT*blockOW) * blockOW + PW : 0;
-        const int owEnd   = owt+1 < OWT ? ((owt+1) * OW + owr) / (OWT*blockOW) * blockOW + PW : OW;
+        ispc::CPUConvKernel curKernel = kernel;
+        curKernel.dst.ptr = rowPtr;
+        ispc::CPUConvKernel_run(&curKernel, 1, 0, tile.hSrcBegin + h,
+                                tile.wSrcBegin, tile.wSrcBegin + tile.W, nullptr);
 
-        ispc::CPUConvKernel_run(&kernel, blockOCB, ocbb * blockOCB, oh, owBegin, owEnd);
+        // Process the row as a single-row tile of the row tensor
+        ispc::CPUOutputProcessKernel curOutputKernel = outputKernel;
+        curOutputKernel.src = rowAcc;
+        curOutputKernel.src.ptr = rowPtr;
+        curOutputKernel.tile.hSrcBegin = 0;
+        curOutputKernel.tile.hDstBegin = tile.hDstBegin + h;
+        curOutputKernel.tile.H = 1;
+        ispc::CPUOutputProcessKernel_run(&curOutputKernel, 0);
       });
     }, ct);
   }
 
-OIDN_NAMESPACE_END
\ No newline at end of file
+OIDN_NAMESPACE_END
@@ -5,6 +5,8 @@
 
 #include "core/conv.h"
 #include "cpu_engine.h"
+#include "cpu_input_process.h"
+#include "cpu_output_process.h"
 
 OIDN_NAMESPACE_BEGIN
 
@@ -14,14 +16,47 @@ OIDN_NAMESPACE_BEGIN
     CPUConv(CPUEngine* engine, const ConvDesc& desc);
 
     Engine* getEngine() const override { return engine; }
+
+    TensorDesc getWeightDesc() const override;
+
+    size_t getScratchByteSize() override;
+    void setScratch(const Ref<Buffer>& scratch) override;
+
+    bool fuseInputProcess(const Ref<InputProcess>& inputProcess) override;
+    bool fuseOutputProcess(const Ref<OutputProcess>& outputProcess) override;
+
+    void finalize() override;
+
+    const char* getTypeName() const override;
+    OpCost getCost() const override;
     void submitKernels(const Ref<CancellationToken>& ct) override;
 
   private:
+    void getTileOW(int owt, int& owBegin, int& owEnd) const;
+    void submitFusedInputKernels(const Ref<CancellationToken>& ct);
+    void submitFusedOutputKernels(const Ref<CancellationToken>& ct);
+
     CPUEngine* engine;
     int blockOCB; // block of output channel blocks
-    int blockOW;  // block of output width
+    int blockOW;  // block of output width (or number of Winograd tiles)
     int OCBB;     // number of output channel block blocks
     int OWT;      // number of output width tiles
+    int maxTileOW = 0; // max width of the output width tiles
+    bool sharedWeights = true; // are all weights assumed to stay in the L2 cache for all work items?
+    int winogradM = 0; // output tile size of Winograd F(m x m, 3x3) convolution (0 if disabled)
+    bool int8Weight = false; // weights quantized to int8 with per output channel scales
+
+    // Fused input processing, which processes and convolves bands of bandH source rows
+    Ref<CPUInputProcess> inputProcess;
+    int bandH = 0;
+
+    // Fused output processing, which processes the output rows on the fly
+    Ref<CPUOutputProcess> outputProcess;
+
+    // Temporary memory for the partial sums of fused post-ops, the Winograd tiles or the fused
+    // output processing rows (per thread)
+    size_t tempByteSize = 0;
+    Ref<Buffer> scratch;
   };
 
 OIDN_NAMESPACE_END
\ No newline at end of file
@@ -20,6 +20,11 @@
   #endif
 #endif
 
+#if defined(__linux__)
+  #include <fstream>
+  #include <cstdio>
+#endif
+
 OIDN_NAMESPACE_BEGIN
 
 #if defined(OIDN_ARCH_X64) && !defined(__APPLE__)
@@ -31,6 +36,49 @@ OIDN_NAMESPACE_BEGIN
     __cpuid(functionID, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
   #endif
   }
+
+  oidn_inline void cpuid(int cpuInfo[4], int functionID, int subFunctionID)
+  {
+  #if defined(_WIN32)
+    __cpuidex(cpuInfo, functionID, subFunctionID);
+  #else
+    __cpuid_count(functionID, subFunctionID, cpuInfo[0], cpuInfo[1], cpuInfo[2], cpuInfo[3]);
+  #endif
+  }
+#endif
+
+#if defined(__linux__)
+  // Reads the first token from a file in /sys/devices/system (empty if it does not exist)
+  static std::string readSysfs(const std::string& filename)
+  {
+    std::ifstream fs(filename.c_str());
+    std::string value;
+    fs >> value;
+    return value;
+  }
+
+  // Returns the number of CPUs in a list from /sys/devices/system (e.g. "0-3,8")
+  static int countSysfsCPUs(const std::string& list)
+  {
+    int count = 0;
+    size_t begin = 0;
+    while (begin < list.size())
+    {
+      size_t end = list.find(',', begin);
+      if (end == std::string::npos)
+        end = list.size();
+
+      int first, last;
+      const int n = sscanf(list.substr(begin, end - begin).c_str(), "%d-%d", &first, &last);
+      if (n == 2)
+        count += last - first + 1;
+      else if (n == 1)
+        count++;
+
+      begin = end + 1;
+    }
+    return count;
+  }
 #endif
 
   CPUPhysicalDevice::CPUPhysicalDevice(int score)
@@ -88,6 +136,166 @@ OIDN_NAMESPACE_BEGIN
     }
   }
 
+  CPUCacheInfo CPUDevice::queryCacheInfo()
+  {
+    CPUCacheInfo info;
+    size_t l1Size = 0, l2Size = 0; // cache sizes of the current core
+
+    // Updates the cache sizes of the current core with the size per core of a cache shared by
+    // numCores cores
+    auto addCache = [&](int level, size_t size, int numCores)
+    {
+      const size_t coreSize = size / max(numCores, 1);
+      if (coreSize == 0)
+        return;
+      if (level == 1)
+        l1Size = l1Size ? min(l1Size, coreSize) : coreSize;
+      else if (level == 2)
+        l2Size = l2Size ? min(l2Size, coreSize) : coreSize;
+    };
+
+    // Adds the cache sizes of the current core to its core type, which is identified by the sizes
+    auto addCore = [&](int numCPUs)
+    {
+      if (l1Size == 0 || l2Size == 0)
+        return;
+      auto coreType = std::find_if(info.coreTypes.begin(), info.coreTypes.end(),
+        [&](const CPUCacheInfo::CoreType& t) { return t.l1Size == l1Size && t.l2Size == l2Size; });
+      if (coreType != info.coreTypes.end())
+        coreType->numCPUs += numCPUs;
+      else
+        info.coreTypes.push_back({l1Size, l2Size, numCPUs});
+      l1Size = l2Size = 0;
+    };
+
+  #if defined(__linux__)
+    // Parse the cache topology of all CPUs, which works for hybrid CPUs as well
+    for (int cpuID = 0; ; ++cpuID)
+    {
+      const std::string cpuDir = "/sys/devices/system/cpu/cpu" + std::to_string(cpuID);
+      const std::string siblings = readSysfs(cpuDir + "/topology/thread_siblings_list");
+      if (siblings.empty())
+        break;
+      const int numThreadsPerCore = max(countSysfsCPUs(siblings), 1);
+
+      for (int index = 0; ; ++index)
+      {
+        const std::string cacheDir = cpuDir + "/cache/index" + std::to_string(index);
+        const std::string level = readSysfs(cacheDir + "/level");
+        if (level.empty())
+          break;
+
+        const std::string type = readSysfs(cacheDir + "/type");
+        if (type != "Data" && type != "Unified")
+          continue;
+
+        // The size has a K/M/G suffix
+        const std::string sizeStr = readSysfs(cacheDir + "/size");
+        char unit = 0;
+        unsigned long size = 0;
+        if (sscanf(sizeStr.c_str(), "%lu%c", &size, &unit) < 1)
+          continue;
+        if (unit == 'K')
+          size <<= 10;
+        else if (unit == 'M')
+          size <<= 20;
+        else if (unit == 'G')
+          size <<= 30;
+
+        const int numCPUs = countSysfsCPUs(readSysfs(cacheDir + "/shared_cpu_list"));
+        addCache(std::stoi(level), size, numCPUs / numThreadsPerCore);
+      }
+
+      addCore(1);
+    }
+  #elif defined(__APPLE__)
+    // Get the caches of each core type (performance level), falling back to the global values
+    int numPerfLevels = 0;
+    getSysctl("hw.nperflevels", numPerfLevels);
+    for (int i = 0; i < numPerfLevels; ++i)
+    {
+      const std::string prefix = "hw.perflevel" + std::to_string(i) + ".";
+      size_t size = 0;
+      int numCPUs = 1;
+      if (getSysctl((prefix + "l1dcachesize").c_str(), size))
+        addCache(1, size, 1);
+      if (getSysctl((prefix + "l2cachesize").c_str(), size))
+      {
+        getSysctl((prefix + "cpusperl2").c_str(), numCPUs);
+        addCache(2, size, numCPUs);
+      }
+      int numLogicalCPUs = 0;
+      getSysctl((prefix + "logicalcpu").c_str(), numLogicalCPUs);
+      addCore(numLogicalCPUs);
+    }
+
+    if (numPerfLevels == 0)
+    {
+      size_t size = 0;
+      if (getSysctl("hw.l1dcachesize", size))
+        addCache(1, size, 1);
+      if (getSysctl("hw.l2cachesize", size))
+        addCache(2, size, 1);
+      addCore(0);
+    }
+  #endif
+
+  #if defined(OIDN_ARCH_X64) && !defined(__APPLE__)
+    // Use the deterministic cache parameters reported by CPUID as fallback (only for the current
+    // core type on hybrid CPUs)
+    if (info.coreTypes.empty())
+    {
+      int regs[4];
+      cpuid(regs, 0);
+      const int maxFunctionID = regs[0];
+
+      if (maxFunctionID >= 4)
+      {
+        int numThreadsPerCore = 1;
+        if (maxFunctionID >= 0xB)
+        {
+          cpuid(regs, 0xB, 0);
+          numThreadsPerCore = max(regs[1] & 0xFFFF, 1);
+        }
+
+        for (int i = 0; ; ++i)
+        {
+          cpuid(regs, 4, i);
+          const int type = regs[0] & 0x1F;
+          if (type == 0)
+            break; // no more caches
+          if (type != 1 && type != 3)
+            continue; // not a data or unified cache
+
+          const int level = (regs[0] >> 5) & 0x7;
+          const int numCPUs = ((regs[0] >> 14) & 0xFFF) + 1;
+          const size_t size = size_t(((regs[1] >> 22) & 0x3FF) + 1) * // ways
+                              size_t(((regs[1] >> 12) & 0x3FF) + 1) * // partitions
+                              size_t((regs[1] & 0xFFF) + 1) *         // line size
+                              (size_t(unsigned(regs[2])) + 1);        // sets
+          addCache(level, size, numCPUs / numThreadsPerCore);
+        }
+      }
+
+      addCore(0);
+    }
+  #endif
+
+    // The data is blocked for the smallest caches among the core types, because the work items
+    // of a kernel are not assigned to cores of a specific type. This is a simplification on hybrid
+    // CPUs, where it makes the blocks of the cores with larger caches smaller than necessary.
+    if (!info.coreTypes.empty())
+    {
+      info.l1Size = info.l2Size = SIZE_MAX;
+      for (const auto& coreType : info.coreTypes)
+      {
+        info.l1Size = min(info.l1Size, coreType.l1Size);
+        info.l2Size = min(info.l2Size, coreType.l2Size);
+      }
+    }
+    return info;
+  }
+
   CPUDevice::CPUDevice()
   {
     systemMemorySupported  = true;
@@ -96,18 +304,38 @@ OIDN_NAMESPACE_BEGIN
     // Get default values from environment variables
     getEnvVar("OIDN_NUM_THREADS", numThreads);
     getEnvVar("OIDN_SET_AFFINITY", setAffinity);
+    getEnvVar("OIDN_NUM_SUBDEVICES", numSubdevices);
+    getEnvVar("OIDN_NUMA", numa);
+    getEnvVar("OIDN_NUM_STREAMS", numStreams);
+    getEnvVar("OIDN_L2_CACHE_SIZE", l2CacheSize);
+    getEnvVar("OIDN_FUSE_PROCESS", fuseProcess);
+    getEnvVar("OIDN_WINOGRAD", winogradM);
+    getEnvVar("OIDN_FUSE_POST_OPS", fusePostOps);
+    getEnvVar("OIDN_GENERIC_PROCESS", genericProcess);
+  }
+
+  CPUDevice::CPUDevice(tbb::task_arena* const* taskArenas, int numArenas)
+    : CPUDevice()
+  {
+    externalArenas.assign(taskArenas, taskArenas + numArenas);
   }
 
   void CPUDevice::init()
   {
     arch = getArch();
 
-    tensorDataType = DataType::Float32;
-    weightDataType = DataType::Float32;
+    // The L2 cache size can be overridden for benchmarking the cache blocking of the kernels
+    cacheInfo = queryCacheInfo();
+    if (l2CacheSize > 0)
+      cacheInfo.l2Size = l2CacheSize;
 
-    std::unique_ptr<CPUEngine> engine;
+    weightDataType = DataType::Float32;
 
   #if defined(OIDN_DNNL)
+    tensorDataType = DataType::Float32;
+    halfPrecision = false; // not supported
+    numStreams = 1; // the DNNL stream cannot be shared by concurrent executions
+
     if (arch == CPUArch::AVX512)
     {
       tensorLayout = TensorLayout::Chw16c;
@@ -120,15 +348,19 @@ OIDN_NAMESPACE_BEGIN
       weightLayout = TensorLayout::OIhw8i8o;
       tensorBlockC = 8;
     }
-
-    engine.reset(new DNNLEngine(this, numThreads));
   #elif defined(OIDN_BNNS)
+    tensorDataType = DataType::Float32;
+    halfPrecision = false; // not supported
+    numStreams = 1; // not supported
+
     tensorLayout = TensorLayout::chw;
     weightLayout = TensorLayout::oihw;
     tensorBlockC = 1;
-
-    engine.reset(new BNNSEngine(this, numThreads));
   #else
+    // Half precision tensors halve the memory bandwidth, the weights and accumulators are always
+    // single precision
+    tensorDataType = halfPrecision ? DataType::Float16 : DataType::Float32;
+
     if (arch == CPUArch::AVX512)
     {
       tensorLayout = TensorLayout::Chw16c;
@@ -141,14 +373,25 @@ OIDN_NAMESPACE_BEGIN
       weightLayout = TensorLayout::IOhw8i8o;
       tensorBlockC = 8;
     }
-
-    engine.reset(new CPUEngine(this, numThreads));
   #endif
 
-    numThreads = engine->arena->max_concurrency();
-    setAffinity = bool(engine->affinity);
+    numStreams = max(numStreams, 1);
 
-    subdevices.emplace_back(new Subdevice(std::move(engine)));
+    if (externalArenas.empty())
+      initEngines();
+    else
+    {
+      // The task arenas of the application are used as they are, without pinning the threads
+      setAffinity = false;
+      numa = false;
+      numSubdevices = int(externalArenas.size());
+      numThreads = 0;
+      for (tbb::task_arena* arena : externalArenas)
+      {
+        addEngine(0, 0, -1, arena);
+        numThreads += static_cast<CPUEngine*>(subdevices.back()->getEngine())->getNumThreads();
+      }
+    }
 
     if (isVerbose())
     {
@@ -165,6 +408,22 @@ OIDN_NAMESPACE_BEGIN
       default:              std::cout << "Unknown"; break;
       }
       std::cout << std::endl;
+      std::cout << "    Caches  : L1 " << cacheInfo.l1Size / 1024 << " KB, L2 "
+                << cacheInfo.l2Size / 1024 << " KB (per core";
+      if (cacheInfo.coreTypes.size() > 1)
+        std::cout << ", smallest of all core types";
+      std::cout << ")" << std::endl;
+      if (cacheInfo.coreTypes.size() > 1)
+      {
+        for (const auto& coreType : cacheInfo.coreTypes)
+        {
+          std::cout << "              L1 " << coreType.l1Size / 1024 << " KB, L2 "
+                    << coreType.l2Size / 1024 << " KB";
+          if (coreType.numCPUs > 0)
+            std::cout << " (" << coreType.numCPUs << " CPUs)";
+          std::cout << std::endl;
+        }
+      }
 
       std::cout << "  Tasking   :";
       std::cout << " TBB" << TBB_VERSION_MAJOR << "." << TBB_VERSION_MINOR;
@@ -175,7 +434,117 @@ OIDN_NAMESPACE_BEGIN
     #endif
       std::cout << std::endl;
       std::cout << "    Threads : " << numThreads << " (" << (setAffinity ? "affinitized" : "non-affinitized") << ")" << std::endl;
+      if (numSubdevices > 1 || !externalArenas.empty())
+        std::cout << "    Arenas  : " << numSubdevices << (numa ? " (NUMA nodes)" : "")
+                  << (externalArenas.empty() ? "" : " (external)") << std::endl;
+      if (numStreams > 1)
+        std::cout << "    Streams : " << numStreams << std::endl;
+      if (halfPrecision)
+        std::cout << "    Tensors : FP16" << std::endl;
+    }
+  }
+
+  void CPUDevice::initEngines()
+  {
+    // Get the thread affinities for one thread per core on non-hybrid CPUs with SMT
+  #if !(defined(__APPLE__) && defined(OIDN_ARCH_ARM64))
+    if (setAffinity
+      #if TBB_INTERFACE_VERSION >= 12020 // oneTBB 2021.2 or later
+        && tbb::info::core_types().size() <= 1 // non-hybrid cores
+      #endif
+       )
+    {
+      affinity = std::make_shared<ThreadAffinity>(1, verbose, numa);
+      if (affinity->getNumThreads() == 0 ||                                           // detection failed
+          tbb::this_task_arena::max_concurrency() == affinity->getNumThreads() ||     // no SMT
+          (tbb::this_task_arena::max_concurrency() % affinity->getNumThreads()) != 0) // hybrid SMT
+        affinity.reset(); // disable affinitization
+    }
+
+    // The NUMA mode requires pinning the threads, so use all hardware threads if pinning one thread
+    // per core is not applicable. If affinitization is disabled by the user, NUMA mode is disabled too.
+    if (numa && setAffinity && !affinity)
+    {
+      affinity = std::make_shared<ThreadAffinity>(INT_MAX, verbose, true);
+      if (affinity->getNumThreads() == 0)
+        affinity.reset();
+    }
+  #endif
+
+    // Get the total number of threads
+    const int maxNumThreads = affinity ? affinity->getNumThreads() : tbb::this_task_arena::max_concurrency();
+    numThreads = (numThreads > 0) ? min(numThreads, maxNumThreads) : maxNumThreads;
+
+    // Get the ranges of the affinitized threads belonging to the same NUMA node
+    struct NumaNodeThreads
+    {
+      int node;
+      int begin;
+      int end;
+    };
+
+    std::vector<NumaNodeThreads> numaNodeThreads;
+    if (numa && affinity)
+    {
+      for (int i = 0; i < maxNumThreads; ++i)
+      {
+        const int node = affinity->getNumaNode(i);
+        if (numaNodeThreads.empty() || numaNodeThreads.back().node != node)
+          numaNodeThreads.push_back({node, i, i});
+        numaNodeThreads.back().end = i + 1;
+      }
+    }
+
+    if (numaNodeThreads.size() > 1)
+    {
+      // Create one subdevice per NUMA node, with the threads pinned to the cores of the node and
+      // the memory allocated on the node, distributing the requested number of threads evenly
+      numSubdevices = int(numaNodeThreads.size());
+      int numEngineThreadsSum = 0;
+      for (const auto& nodeThreads : numaNodeThreads)
+      {
+        const int numNodeThreads = nodeThreads.end - nodeThreads.begin;
+        const int numEngineThreads = max(numNodeThreads * numThreads / maxNumThreads, 1);
+        addEngine(numEngineThreads, nodeThreads.begin, nodeThreads.node);
+        numEngineThreadsSum += numEngineThreads;
+      }
+
+      numThreads = numEngineThreadsSum;
+    }
+    else
+    {
+      numa = false; // single NUMA node or no thread affinities
+
+      // Split the threads between the subdevices, each having its own engine and task arena, which
+      // enables denoising multiple tiles in parallel
+      numSubdevices = clamp(numSubdevices, 1, numThreads);
+      int threadIndexOffset = 0;
+      for (int i = 0; i < numSubdevices; ++i)
+      {
+        const int numEngineThreads = numThreads / numSubdevices + (i < numThreads % numSubdevices ? 1 : 0);
+        addEngine(numEngineThreads, threadIndexOffset);
+        threadIndexOffset += numEngineThreads;
+      }
+
+      numThreads = threadIndexOffset;
     }
+
+    setAffinity = bool(affinity);
+  }
+
+  void CPUDevice::addEngine(int numThreads, int threadIndexOffset, int numaNode,
+                            tbb::task_arena* externalArena)
+  {
+    std::unique_ptr<CPUEngine> engine;
+  #if defined(OIDN_DNNL)
+    engine.reset(new DNNLEngine(this, numThreads, threadIndexOffset, numaNode, externalArena));
+  #elif defined(OIDN_BNNS)
+    engine.reset(new BNNSEngine(this, numThreads, threadIndexOffset, numaNode, externalArena));
+  #else
+    engine.reset(new CPUEngine(this, numThreads, threadIndexOffset, numaNode, externalArena));
+  #endif
+
+    subdevices.emplace_back(new Subdevice(std::move(engine)));
   }
 
   Storage CPUDevice::getPtrStorage(const void* ptr)
@@ -189,6 +558,14 @@ OIDN_NAMESPACE_BEGIN
       return numThreads;
     else if (name == "setAffinity")
       return setAffinity;
+    else if (name == "numSubdevices")
+      return numSubdevices;
+    else if (name == "numa")
+      return numa;
+    else if (name == "numStreams")
+      return numStreams;
+    else if (name == "halfPrecision")
+      return halfPrecision;
     else
       return Device::getInt(name);
   }
@@ -209,12 +586,84 @@ OIDN_NAMESPACE_BEGIN
       else if (setAffinity != bool(value))
         printWarning("OIDN_SET_AFFINITY environment variable overrides device parameter");
     }
+    else if (name == "numSubdevices")
+    {
+      if (!isEnvVar("OIDN_NUM_SUBDEVICES"))
+        numSubdevices = value;
+      else if (numSubdevices != value)
+        printWarning("OIDN_NUM_SUBDEVICES environment variable overrides device parameter");
+    }
+    else if (name == "numa")
+    {
+      if (!isEnvVar("OIDN_NUMA"))
+        numa = value;
+      else if (numa != bool(value))
+        printWarning("OIDN_NUMA environment variable overrides device parameter");
+    }
+    else if (name == "numStreams")
+    {
+      if (!isEnvVar("OIDN_NUM_STREAMS"))
+        numStreams = value;
+      else if (numStreams != value)
+        printWarning("OIDN_NUM_STREAMS environment variable overrides device parameter");
+    }
+    else if (name == "halfPrecision")
+      halfPrecision = value;
     else
       Device::setInt(name, value);
 
     dirty = true;
   }
 
+  void CPUDevice::setStream(int streamID)
+  {
+    CPUEngine::curStreamID = streamID;
+  }
+
+  void CPUDevice::execute(std::function<void()>&& f, SyncMode sync)
+  {
+    // Blocking executions on a single engine submit the operations inline, executing them on the
+    // calling thread in the task arena, which avoids the context switches to/from the queue thread
+    if (sync == SyncMode::Blocking && getNumSubdevices() == 1)
+    {
+      auto engine = static_cast<CPUEngine*>(getEngine());
+      engine->executeInline([&]() { Device::execute(std::move(f), sync); });
+    }
+    else
+      Device::execute(std::move(f), sync);
+  }
+
+  void CPUDevice::submitBarrier()
+  {
+    // We need a barrier only if there are at least 2 subdevices
+    const int numSubdevices = getNumSubdevices();
+    if (numSubdevices < 2)
+      return;
+
+    // Each engine blocks its queue until all engines have reached the barrier
+    struct Barrier
+    {
+      std::mutex mutex;
+      std::condition_variable cond;
+      int count;
+    };
+
+    auto barrier = std::make_shared<Barrier>();
+    barrier->count = numSubdevices;
+
+    for (int i = 0; i < numSubdevices; ++i)
+    {
+      static_cast<CPUEngine*>(getEngine(i))->submitFunc([barrier]()
+      {
+        std::unique_lock<std::mutex> lock(barrier->mutex);
+        if (--barrier->count == 0)
+          barrier->cond.notify_all();
+        else
+          barrier->cond.wait(lock, [&] { return barrier->count == 0; });
+      });
+    }
+  }
+
   void CPUDevice::wait()
   {
     for (auto& subdevice : subdevices)
@@ -21,6 +21,23 @@ OIDN_NAMESPACE_BEGIN
     NEON
   };
 
+  // Sizes of the CPU data caches available to a single core. On hybrid CPUs these are the smallest
+  // sizes among the core types, so the data blocked for the caches fits on any core.
+  struct CPUCacheInfo
+  {
+    // Cache sizes of a core type (e.g. performance or efficiency cores)
+    struct CoreType
+    {
+      size_t l1Size;
+      size_t l2Size;
+      int numCPUs; // number of logical CPUs of this type (0 if unknown)
+    };
+
+    size_t l1Size = 32 * 1024;  // L1 data cache
+    size_t l2Size = 512 * 1024; // L2 cache
+    std::vector<CoreType> coreTypes; // detected core types (empty if the detection failed)
+  };
+
   class CPUPhysicalDevice final : public PhysicalDevice
   {
   public:
@@ -36,29 +53,54 @@ OIDN_NAMESPACE_BEGIN
     static std::vector<Ref<PhysicalDevice>> getPhysicalDevices();
     static std::string getName();
     static CPUArch getArch();
+    static CPUCacheInfo queryCacheInfo();
 
     CPUDevice();
+    CPUDevice(tbb::task_arena* const* taskArenas, int numArenas);
 
     DeviceType getType() const override { return DeviceType::CPU; }
+    const CPUCacheInfo& getCacheInfo() const { return cacheInfo; }
 
   #if !defined(OIDN_DNNL)
-    bool needWeightAndBiasOnDevice() const override { return false; } // no need to copy
+    bool needWeightAndBiasOnDevice() const override { return numa; } // replicate per NUMA node
   #endif
     Storage getPtrStorage(const void* ptr) override;
 
     int getInt(const std::string& name) override;
     void setInt(const std::string& name, int value) override;
 
+    void setStream(int streamID) override;
+    void execute(std::function<void()>&& f, SyncMode sync) override;
+    void submitBarrier() override;
     void wait() override;
 
   protected:
     void init() override;
 
   private:
+    // Creates the engines with new task arenas
+    void initEngines();
+
+    // Creates a subdevice with a new engine
+    void addEngine(int numThreads, int threadIndexOffset, int numaNode = -1,
+                   tbb::task_arena* externalArena = nullptr);
+
     CPUArch arch = CPUArch::Unknown;
+    CPUCacheInfo cacheInfo;
+    size_t l2CacheSize = 0; // autodetect by default
+    bool fuseProcess = true; // fuse the input/output processing into the first/last convolutions
+    int winogradM = -1;      // Winograd output tile size (2 or 4, 0 to disable), automatic by default
+    bool fusePostOps = true; // fuse pooling and upsampling into the preceding convolutions
+    bool genericProcess = false; // use the generic input/output processing kernels for all formats
 
     int numThreads = 0; // autodetect by default
     bool setAffinity = true;
+    int numSubdevices = 1; // number of engines with separate task arenas, sharing the threads
+    bool numa = false; // create one engine per NUMA node with node-local threads and memory
+    bool halfPrecision = false; // store the intermediate tensors in half precision
+
+    std::shared_ptr<ThreadAffinity> affinity; // thread affinity manager for pinning threads
+    std::vector<tbb::task_arena*> externalArenas; // task arenas of the application to use (one per engine)
   };
 
 OIDN_NAMESPACE_END
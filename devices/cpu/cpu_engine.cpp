@@ -12,54 +12,65 @@
 #include "cpu_output_process.h"
 #include "cpu_image_copy.h"
 
+#if defined(__linux__)
+  #include <unistd.h>
+  #include <sys/syscall.h>
+#endif
+
 OIDN_NAMESPACE_BEGIN
 
-  CPUEngine::CPUEngine(CPUDevice* device, int numThreads)
-    : device(device)
+  thread_local int CPUEngine::curStreamID = -1;
+  thread_local bool CPUEngine::curInline = false;
+  thread_local std::vector<CPUTaskQueue::Task>* CPUEngine::curCapture = nullptr;
+
+  CPUEngine::CPUEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode,
+                       tbb::task_arena* externalArena)
+    : device(device),
+      numaNode(numaNode)
   {
-    // Get the thread affinities for one thread per core on non-hybrid CPUs with SMT
-  #if !(defined(__APPLE__) && defined(OIDN_ARCH_ARM64))
-    if (device->setAffinity
-      #if TBB_INTERFACE_VERSION >= 12020 // oneTBB 2021.2 or later
-        && tbb::info::core_types().size() <= 1 // non-hybrid cores
-      #endif
-       )
+    // Create the task arena, or use the external one owned by the application
+    if (externalArena)
     {
-      affinity = std::make_shared<ThreadAffinity>(1, device->verbose);
-      if (affinity->getNumThreads() == 0 ||                                           // detection failed
-          tbb::this_task_arena::max_concurrency() == affinity->getNumThreads() ||     // no SMT
-          (tbb::this_task_arena::max_concurrency() % affinity->getNumThreads()) != 0) // hybrid SMT
-        affinity.reset(); // disable affinitization
+      externalArena->initialize(); // does nothing if already initialized
+      arena = std::shared_ptr<tbb::task_arena>(externalArena, [](tbb::task_arena*) {});
     }
-  #endif
+    else
+      arena = std::make_shared<tbb::task_arena>(numThreads);
 
-    // Create the task arena
-    const int maxNumThreads = affinity ? affinity->getNumThreads() : tbb::this_task_arena::max_concurrency();
-    numThreads = (numThreads > 0) ? min(numThreads, maxNumThreads) : maxNumThreads;
-    arena = std::make_shared<tbb::task_arena>(numThreads);
+    // Automatically set the thread affinities (only in our own arena)
+    if (device->affinity && !externalArena)
+      observer = std::make_shared<PinningObserver>(device->affinity, *arena, threadIndexOffset);
 
-    // Automatically set the thread affinities
-    if (affinity)
-      observer = std::make_shared<PinningObserver>(affinity, *arena);
-
-    // Start the queue processing thread
-    queueThread = std::thread([&]() { processQueue(); });
+    // Create the streams and start their queue processing threads
+    for (int i = 0; i < device->numStreams; ++i)
+    {
+      streams.emplace_back(new Stream);
+      Stream* stream = streams.back().get();
+      stream->queueThread = std::thread([=]() { processQueue(*stream); });
+    }
   }
 
   CPUEngine::~CPUEngine()
   {
+    for (auto& stream : streams)
     {
-      std::lock_guard<std::mutex> lock(queueMutex);
-      queueShutdown = true;
+      stream->queue.shutdown();
+      stream->queueThread.join();
     }
-    queueCond.notify_all();
-    queueThread.join();
 
     if (observer)
       observer.reset();
   }
 
 #if !defined(OIDN_DNNL) && !defined(OIDN_BNNS)
+  bool CPUEngine::isConvSupported(PostOp postOp)
+  {
+    // The fusion of the post-ops can be disabled (e.g. for testing), which splits them into
+    // separate pooling and upsampling ops
+    return postOp == PostOp::None ||
+           (device->fusePostOps && (postOp == PostOp::Pool || postOp == PostOp::Upsample));
+  }
+
   Ref<Conv> CPUEngine::newConv(const ConvDesc& desc)
   {
     return makeRef<CPUConv>(this, desc);
@@ -98,11 +109,12 @@ OIDN_NAMESPACE_BEGIN
 
   void CPUEngine::submitFunc(std::function<void()>&& f, const Ref<CancellationToken>& ct)
   {
-    {
-      std::lock_guard<std::mutex> lock(queueMutex);
-      queue.push({std::move(f), ct});
-    }
-    queueCond.notify_all();
+    if (curCapture)
+      curCapture->push_back({std::move(f), ct});
+    else if (curInline)
+      runTask(f, ct);
+    else
+      getStream().queue.push({std::move(f), ct});
   }
 
   void CPUEngine::submitHostFunc(std::function<void()>&& f, const Ref<CancellationToken>& ct)
@@ -110,14 +122,94 @@ OIDN_NAMESPACE_BEGIN
     submitFunc(std::move(f), ct);
   }
 
+  void CPUEngine::submitConcurrent(const std::vector<std::function<void()>>& funcs)
+  {
+    // Capture the functions submitted by each function into a separate lane
+    auto lanes = std::make_shared<std::vector<std::vector<CPUTaskQueue::Task>>>(funcs.size());
+    std::vector<CPUTaskQueue::Task>* prevCapture = curCapture;
+
+    try
+    {
+      for (size_t i = 0; i < funcs.size(); ++i)
+      {
+        curCapture = &(*lanes)[i];
+        funcs[i]();
+      }
+    }
+    catch (...)
+    {
+      curCapture = prevCapture;
+      throw;
+    }
+
+    curCapture = prevCapture;
+
+    // Execute the lanes concurrently, and the functions of each lane in order. The kernels of the
+    // lanes share the threads of the arena, so lanes with little parallelism (e.g. the convolutions
+    // at the lowest resolutions) leave the threads to the other lanes.
+    submitFunc([this, lanes]
+    {
+      tbb::task_group group;
+      for (auto& lane : *lanes)
+      {
+        group.run([this, &lane]
+        {
+          for (auto& task : lane)
+            runTask(task.func, task.ct);
+        });
+      }
+      group.wait();
+    });
+  }
+
   void CPUEngine::wait()
   {
+    // Wait only for the stream of the calling thread, if set
+    if (curStreamID >= 0)
+      wait(getStream());
+    else
     {
-      std::unique_lock<std::mutex> lock(queueMutex);
-      queueCond.wait(lock, [&] { return queue.empty(); });
+      for (auto& stream : streams)
+        wait(*stream);
     }
   }
 
+  void CPUEngine::wait(Stream& stream)
+  {
+    stream.queue.wait();
+  }
+
+  void CPUEngine::executeInline(const std::function<void()>& f)
+  {
+    // The previously enqueued functions must be executed first to preserve the order
+    wait();
+
+    // The function is executed on the calling thread if the arena has a free slot, otherwise by a
+    // worker thread, so the state of the calling thread must be set inside the arena
+    const int streamID = curStreamID;
+    arena->execute([&]
+    {
+      const int prevStreamID = curStreamID;
+      const bool prevInline  = curInline;
+      curStreamID = streamID;
+      curInline   = true;
+
+      try
+      {
+        f();
+      }
+      catch (...)
+      {
+        curStreamID = prevStreamID;
+        curInline   = prevInline;
+        throw;
+      }
+
+      curStreamID = prevStreamID;
+      curInline   = prevInline;
+    });
+  }
+
   void* CPUEngine::usmAlloc(size_t byteSize, Storage storage)
   {
     if (storage != Storage::Host && storage != Storage::Device && storage != Storage::Managed)
@@ -125,6 +217,29 @@ OIDN_NAMESPACE_BEGIN
 
     if (byteSize == 0)
       return nullptr;
+
+  #if defined(__linux__) && defined(SYS_mbind)
+    if (numaNode >= 0)
+    {
+      // Allocate whole pages and prefer placing them on the NUMA node of the engine. The pages are
+      // physically allocated only when first touched, which normally happens in the pinned arena
+      // anyway, but the policy also covers memory first touched by other threads (e.g. copies)
+      const size_t pageSize = size_t(sysconf(_SC_PAGESIZE));
+      const size_t allocByteSize = round_up(byteSize, pageSize);
+      void* ptr = alignedMalloc(allocByteSize, pageSize);
+
+      const size_t numMaskBits = sizeof(unsigned long) * 8;
+      std::vector<unsigned long> nodeMask(numaNode / numMaskBits + 1, 0);
+      nodeMask[numaNode / numMaskBits] = 1ul << (numaNode % numMaskBits);
+      const long mpolPreferred = 1; // MPOL_PREFERRED
+      if (syscall(SYS_mbind, ptr, allocByteSize, mpolPreferred,
+                  nodeMask.data(), nodeMask.size() * numMaskBits + 1, 0) != 0)
+        device->printWarning("mbind failed");
+
+      return ptr;
+    }
+  #endif
+
     return alignedMalloc(byteSize);
   }
 
@@ -145,45 +260,30 @@ OIDN_NAMESPACE_BEGIN
     submitFunc([=] { std::memcpy(dstPtr, srcPtr, byteSize); });
   }
 
-  void CPUEngine::processQueue()
+  void CPUEngine::processQueue(Stream& stream)
   {
-    for (; ;)
+    // Wait until a task is available in the queue
+    while (CPUTaskQueue::Task* task = stream.queue.front())
     {
-      Task task;
-
-      // Wait until a task is available in the queue
-      {
-        std::unique_lock<std::mutex> lock(queueMutex);
-        queueCond.wait(lock, [&] { return !queue.empty() || queueShutdown; });
-        if (queue.empty() && queueShutdown)
-          return;
-        task = std::move(queue.front());
-      }
-
       // Execute queued tasks in the arena until the queue gets empty
       arena->execute([&]
       {
-        for (; ;)
+        do
         {
-          if (task.ct && task.ct->isCancelled())
-            device->setAsyncError(Error::Cancelled, "execution was cancelled");
-          else
-            task.func();
-
-          task = {};
-
-          {
-            std::lock_guard<std::mutex> lock(queueMutex);
-            queue.pop();
-            if (queue.empty())
-              break;
-            task = std::move(queue.front());
-          }
+          runTask(task->func, task->ct);
+          stream.queue.pop();
         }
-
-        queueCond.notify_all();
+        while ((task = stream.queue.tryFront()));
       });
     }
   }
 
+  void CPUEngine::runTask(const std::function<void()>& f, const Ref<CancellationToken>& ct)
+  {
+    if (ct && ct->isCancelled())
+      device->setAsyncError(Error::Cancelled, "execution was cancelled");
+    else
+      f();
+  }
+
 OIDN_NAMESPACE_END
@@ -5,9 +5,8 @@
 
 #include "core/engine.h"
 #include "cpu_device.h"
-#include <queue>
+#include "cpu_task_queue.h"
 #include <thread>
-#include <condition_variable>
 
 OIDN_NAMESPACE_BEGIN
 
@@ -16,14 +15,21 @@ OIDN_NAMESPACE_BEGIN
     friend class CPUDevice;
 
   public:
-    CPUEngine(CPUDevice* device, int numThreads);
+    CPUEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode = -1,
+              tbb::task_arena* externalArena = nullptr);
     ~CPUEngine();
 
     Device* getDevice() const override { return device; }
-    int getNumThreads() const { return device->numThreads; }
+    int getNumThreads() const { return arena->max_concurrency(); }
+    int getNumaNode() const { return numaNode; }
+    const CPUCacheInfo& getCacheInfo() const { return device->getCacheInfo(); }
+    bool isProcessFusionEnabled() const { return device->fuseProcess; }
+    int getWinogradM() const { return device->winogradM; }
+    bool isProcessSpecializationEnabled() const { return !device->genericProcess; }
 
     // Ops
   #if !defined(OIDN_DNNL) && !defined(OIDN_BNNS)
+    bool isConvSupported(PostOp postOp) override;
     Ref<Conv> newConv(const ConvDesc& desc) override;
   #endif
     Ref<Pool> newPool(const PoolDesc& desc) override;
@@ -45,29 +51,43 @@ OIDN_NAMESPACE_BEGIN
     // Enqueues a host function
     void submitHostFunc(std::function<void()>&& f, const Ref<CancellationToken>& ct) override;
 
+    // Enqueues the functions submitted by each function as a single task, which executes them
+    // concurrently in the task arena
+    bool isConcurrentSubmitSupported() const override { return true; }
+    void submitConcurrent(const std::vector<std::function<void()>>& funcs) override;
+
     void wait() override;
 
+    // Executes a function on the calling thread in the task arena, with all functions submitted
+    // by it executed immediately instead of being enqueued, after waiting for the enqueued ones
+    void executeInline(const std::function<void()>& f);
+
   protected:
-    struct Task
+    // Queue for executing functions asynchronously, in order
+    struct Stream
     {
-      std::function<void()> func;
-      Ref<CancellationToken> ct;
+      CPUTaskQueue queue;                      // queue of tasks to execute
+      std::thread queueThread;                 // thread that processes the queue
     };
 
-    void processQueue();
+    // Returns the stream to which the calling thread submits functions
+    Stream& getStream() { return *streams[curStreamID >= 0 ? curStreamID : 0]; }
+
+    void processQueue(Stream& stream);
+    void runTask(const std::function<void()>& f, const Ref<CancellationToken>& ct);
+    void wait(Stream& stream);
 
     CPUDevice* device;
+    int numaNode; // NUMA node to which the threads and memory are bound (-1 if none)
 
-    // Queue for executing functions asynchronously
-    std::queue<Task> queue;                    // queue of tasks to execute
-    bool queueShutdown = false;                // flag to signal the queue thread to shutdown
-    std::thread queueThread;                   // thread that processes the queue
-    std::mutex queueMutex;                     // mutex for the queue
-    std::condition_variable queueCond;         // condition variable for the queue
+    // Streams sharing the task arena, which enables executing independent filters concurrently
+    std::vector<std::unique_ptr<Stream>> streams;
+    static thread_local int curStreamID;       // stream of the calling thread (-1 if none)
+    static thread_local bool curInline;        // are functions executed inline by the calling thread?
+    static thread_local std::vector<CPUTaskQueue::Task>* curCapture; // captured functions (if not null)
 
-    std::shared_ptr<tbb::task_arena> arena;    // task arena where the functions are executed
+    std::shared_ptr<tbb::task_arena> arena;    // task arena where the functions are executed (may be external)
     std::shared_ptr<PinningObserver> observer; // task scheduler observer for pinning threads
-    std::shared_ptr<ThreadAffinity> affinity;  // thread affinity manager for pinning threads
   };
 
 OIDN_NAMESPACE_END
@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "cpu_input_process.h"
-#include "cpu_input_process_ispc.h"
 #include "cpu_common.h"
 
 OIDN_NAMESPACE_BEGIN
@@ -12,7 +11,7 @@ OIDN_NAMESPACE_BEGIN
       engine(engine)
   {}
 
-  void CPUInputProcess::submitKernels(const Ref<CancellationToken>& ct)
+  ispc::CPUInputProcessKernel CPUInputProcess::getKernel()
   {
     check();
 
@@ -28,6 +27,22 @@ OIDN_NAMESPACE_BEGIN
     kernel.hdr   = hdr;
     kernel.snorm = snorm;
 
+    // Select the kernel variant specialized for the image format and transfer function
+    ispc::CPUInputProcessKernel_init(&kernel, engine->isProcessSpecializationEnabled());
+
+    return kernel;
+  }
+
+  void CPUInputProcess::submitKernels(const Ref<CancellationToken>& ct)
+  {
+    if (fused)
+    {
+      check();
+      return;
+    }
+
+    ispc::CPUInputProcessKernel kernel = getKernel();
+
     engine->submitFunc([=]
     {
       parallel_for(kernel.dst.H, [&](int hDst)
@@ -37,4 +52,10 @@ OIDN_NAMESPACE_BEGIN
     }, ct);
   }
 
-OIDN_NAMESPACE_END
\ No newline at end of file
+  OpCost CPUInputProcess::getCost() const
+  {
+    // The cost of fused input processing is accounted to the fused operation
+    return fused ? OpCost() : InputProcess::getCost();
+  }
+
+OIDN_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include "core/input_process.h"
 #include "cpu_engine.h"
+#include "cpu_input_process_ispc.h"
 
 OIDN_NAMESPACE_BEGIN
 
@@ -15,9 +16,19 @@ OIDN_NAMESPACE_BEGIN
 
     Engine* getEngine() const override { return engine; }
     void submitKernels(const Ref<CancellationToken>& ct) override;
+    OpCost getCost() const override;
+
+    // Fused input processing is performed by the consuming operation (e.g. convolution) using the
+    // kernel returned by getKernel, so submitting it does nothing
+    bool isFused() const override { return fused; }
+    void setFused() { fused = true; }
+
+    // Returns the kernel for the current source, destination and tile
+    ispc::CPUInputProcessKernel getKernel();
 
   private:
     CPUEngine* engine;
+    bool fused = false;
   };
 
 OIDN_NAMESPACE_END
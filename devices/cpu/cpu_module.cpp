@@ -6,9 +6,24 @@
 
 OIDN_NAMESPACE_BEGIN
 
-  class CPUDeviceFactory : public DeviceFactory
+  class CPUDeviceFactory : public CPUDeviceFactoryBase
   {
   public:
+    Ref<Device> newDevice(void* const* taskArenas, int numArenas) override
+    {
+      if (numArenas < 1)
+        throw Exception(Error::InvalidArgument, "invalid number of TBB task arenas");
+      if (taskArenas == nullptr)
+        throw Exception(Error::InvalidArgument, "array of TBB task arenas is null");
+      for (int i = 0; i < numArenas; ++i)
+      {
+        if (taskArenas[i] == nullptr)
+          throw Exception(Error::InvalidArgument, "TBB task arena is null");
+      }
+
+      return makeRef<CPUDevice>(reinterpret_cast<tbb::task_arena* const*>(taskArenas), numArenas);
+    }
+
     Ref<Device> newDevice(const Ref<PhysicalDevice>& physicalDevice) override
     {
       assert(physicalDevice->type == DeviceType::CPU);
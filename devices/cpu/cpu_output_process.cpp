@@ -2,7 +2,6 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "cpu_output_process.h"
-#include "cpu_output_process_ispc.h"
 #include "cpu_common.h"
 
 OIDN_NAMESPACE_BEGIN
@@ -12,19 +11,39 @@ OIDN_NAMESPACE_BEGIN
       engine(engine)
   {}
 
-  void CPUOutputProcess::submitKernels(const Ref<CancellationToken>& ct)
+  ispc::CPUOutputProcessKernel CPUOutputProcess::getKernel()
   {
-    check();
+    if (fused)
+      checkDst();
+    else
+      check();
 
     ispc::CPUOutputProcessKernel kernel;
 
-    kernel.src = *src;
+    if (src)
+      kernel.src = *src;
     kernel.dst = *dst;
     kernel.tile = toISPC(tile);
     kernel.transferFunc = toISPC(*transferFunc);
     kernel.hdr = hdr;
     kernel.snorm = snorm;
 
+    // Select the kernel variant specialized for the image format and transfer function
+    ispc::CPUOutputProcessKernel_init(&kernel, engine->isProcessSpecializationEnabled());
+
+    return kernel;
+  }
+
+  void CPUOutputProcess::submitKernels(const Ref<CancellationToken>& ct)
+  {
+    if (fused)
+    {
+      checkDst();
+      return;
+    }
+
+    ispc::CPUOutputProcessKernel kernel = getKernel();
+
     engine->submitFunc([=]
     {
       parallel_for(kernel.tile.H, [&](int h)
@@ -34,4 +53,10 @@ OIDN_NAMESPACE_BEGIN
     }, ct);
   }
 
-OIDN_NAMESPACE_END
\ No newline at end of file
+  OpCost CPUOutputProcess::getCost() const
+  {
+    // The cost of fused output processing is accounted to the fused operation
+    return fused ? OpCost() : OutputProcess::getCost();
+  }
+
+OIDN_NAMESPACE_END
@@ -5,6 +5,7 @@
 
 #include "core/output_process.h"
 #include "cpu_engine.h"
+#include "cpu_output_process_ispc.h"
 
 OIDN_NAMESPACE_BEGIN
 
@@ -15,9 +16,19 @@ OIDN_NAMESPACE_BEGIN
 
     Engine* getEngine() const override { return engine; }
     void submitKernels(const Ref<CancellationToken>& ct) override;
+    OpCost getCost() const override;
+
+    // Fused output processing is performed by the producing operation (e.g. convolution) using the
+    // kernel returned by getKernel, so submitting it does nothing and the source is not needed
+    bool isFused() const override { return fused; }
+    void setFused() { fused = true; }
+
+    // Returns the kernel for the current source (if set), destination and tile
+    ispc::CPUOutputProcessKernel getKernel();
 
   private:
     CPUEngine* engine;
+    bool fused = false;
   };
 
 OIDN_NAMESPACE_END
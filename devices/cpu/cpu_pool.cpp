@@ -14,6 +14,8 @@ OIDN_NAMESPACE_BEGIN
     if (srcDesc.layout != TensorLayout::Chw8c &&
         srcDesc.layout != TensorLayout::Chw16c)
       throw std::invalid_argument("unsupported pooling source layout");
+    if (srcDesc.dataType != DataType::Float32)
+      throw std::invalid_argument("unsupported pooling source data type");
   }
 
   void CPUPool::submitKernels(const Ref<CancellationToken>& ct)
@@ -0,0 +1,104 @@
+// Copyright 2024 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "cpu_task_queue.h"
+
+OIDN_NAMESPACE_BEGIN
+
+  constexpr size_t CPUTaskQueue::capacity;
+
+  CPUTaskQueue::CPUTaskQueue()
+    : tail(0),
+      head(0),
+      consumerSleeping(false),
+      producerSleeping(false)
+  {
+    static_assert((capacity & (capacity - 1)) == 0, "task queue capacity must be a power of 2");
+  }
+
+  void CPUTaskQueue::push(Task&& task)
+  {
+    const size_t curTail = tail.load(std::memory_order_relaxed);
+
+    // Wait until there is space in the queue
+    if (curTail - head.load(std::memory_order_acquire) == capacity)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      producerSleeping.store(true);
+      producerCond.wait(lock, [&] { return curTail - head.load() < capacity; });
+      producerSleeping.store(false);
+    }
+
+    tasks[curTail % capacity] = std::move(task);
+
+    // The stores and loads of the index and the sleeping flag must be sequentially consistent to
+    // ensure that either the consumer sees the new task or the producer sees the sleeping consumer
+    tail.store(curTail + 1);
+
+    if (consumerSleeping.load())
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      consumerCond.notify_one();
+    }
+  }
+
+  void CPUTaskQueue::wait()
+  {
+    const size_t curTail = tail.load(std::memory_order_relaxed);
+    if (head.load(std::memory_order_acquire) == curTail)
+      return;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    producerSleeping.store(true);
+    producerCond.wait(lock, [&] { return head.load() == curTail; });
+    producerSleeping.store(false);
+  }
+
+  CPUTaskQueue::Task* CPUTaskQueue::front()
+  {
+    const size_t curHead = head.load(std::memory_order_relaxed);
+
+    // Wait until a task is available in the queue
+    if (tail.load(std::memory_order_acquire) == curHead)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      consumerSleeping.store(true);
+      consumerCond.wait(lock, [&] { return tail.load() != curHead || isShutdown; });
+      consumerSleeping.store(false);
+      if (tail.load() == curHead)
+        return nullptr; // shutdown
+    }
+
+    return &tasks[curHead % capacity];
+  }
+
+  CPUTaskQueue::Task* CPUTaskQueue::tryFront()
+  {
+    const size_t curHead = head.load(std::memory_order_relaxed);
+    if (tail.load(std::memory_order_acquire) == curHead)
+      return nullptr;
+    return &tasks[curHead % capacity];
+  }
+
+  void CPUTaskQueue::pop()
+  {
+    const size_t curHead = head.load(std::memory_order_relaxed);
+    tasks[curHead % capacity] = {}; // release the resources of the task
+    head.store(curHead + 1);
+
+    // Wake up the producer if it waits for space or for the completion of the tasks
+    if (producerSleeping.load())
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      producerCond.notify_all();
+    }
+  }
+
+  void CPUTaskQueue::shutdown()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isShutdown = true;
+    consumerCond.notify_all();
+  }
+
+OIDN_NAMESPACE_END
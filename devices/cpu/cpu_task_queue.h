@@ -0,0 +1,73 @@
+// Copyright 2024 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "core/engine.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+OIDN_NAMESPACE_BEGIN
+
+  // Lock-free single-producer/single-consumer ring buffer of tasks. The producer and the consumer
+  // block on a mutex only if they have to sleep: the consumer when the queue is empty, the producer
+  // when the queue is full or when waiting for the completion of all tasks. Sleeping threads are
+  // woken up only on the corresponding state transitions, thus pushing to a non-empty queue and
+  // popping while nobody waits are wait-free.
+  class CPUTaskQueue
+  {
+  public:
+    struct Task
+    {
+      std::function<void()> func;
+      Ref<CancellationToken> ct;
+    };
+
+    static constexpr size_t capacity = 1024; // maximum number of queued tasks (power of 2)
+
+    CPUTaskQueue();
+
+    // Producer: enqueues a task, blocking if the queue is full
+    void push(Task&& task);
+
+    // Producer: blocks until all tasks have been popped
+    void wait();
+
+    // Consumer: returns the next task, blocking until one is available, or nullptr on shutdown
+    Task* front();
+
+    // Consumer: returns the next task if available, without blocking
+    Task* tryFront();
+
+    // Consumer: releases the current task, which must have been completed
+    void pop();
+
+    // Makes the consumer return from front() once the queue gets empty
+    void shutdown();
+
+  private:
+    // Disable copying
+    CPUTaskQueue(const CPUTaskQueue&) = delete;
+    CPUTaskQueue& operator =(const CPUTaskQueue&) = delete;
+
+    Task tasks[capacity];
+
+    // The producer and the consumer indices are kept in separate cache lines to avoid false sharing
+    // (padding is used because over-aligned heap allocations are not supported before C++17)
+    static constexpr size_t cacheLineSize = 64;
+    char padding0[cacheLineSize];
+    std::atomic<size_t> tail; // index of the next pushed task, written by the producer
+    char padding1[cacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> head; // index of the next popped task, written by the consumer
+    char padding2[cacheLineSize - sizeof(std::atomic<size_t>)];
+
+    std::mutex mutex;                          // mutex for sleeping
+    std::condition_variable consumerCond;      // signaled when a task is pushed to an empty queue
+    std::condition_variable producerCond;      // signaled when space is freed or the queue gets empty
+    std::atomic<bool> consumerSleeping;        // is the consumer waiting for a task?
+    std::atomic<bool> producerSleeping;        // is the producer waiting for space or completion?
+    bool isShutdown = false;
+  };
+
+OIDN_NAMESPACE_END
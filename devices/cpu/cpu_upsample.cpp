@@ -15,6 +15,8 @@ OIDN_NAMESPACE_BEGIN
         srcDesc.layout != TensorLayout::Chw8c &&
         srcDesc.layout != TensorLayout::Chw16c)
       throw std::invalid_argument("unsupported upsampling source layout");
+    if (srcDesc.dataType != DataType::Float32)
+      throw std::invalid_argument("unsupported upsampling source data type");
   }
 
   void CPUUpsample::submitKernels(const Ref<CancellationToken>& ct)
@@ -16,6 +16,8 @@ OIDN_NAMESPACE_BEGIN
       return dnnl::memory::data_type::f16;
     case DataType::UInt8:
       return dnnl::memory::data_type::u8;
+    case DataType::Int8:
+      return dnnl::memory::data_type::s8;
     default:
       throw std::invalid_argument("unsupported data type");
     }
@@ -7,8 +7,9 @@
 
 OIDN_NAMESPACE_BEGIN
 
-  DNNLEngine::DNNLEngine(CPUDevice* device, int numThreads)
-    : CPUEngine(device, numThreads)
+  DNNLEngine::DNNLEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode,
+                         tbb::task_arena* externalArena)
+    : CPUEngine(device, numThreads, threadIndexOffset, numaNode, externalArena)
   {
     dnnl_set_verbose(clamp(device->verbose - 2, 0, 2)); // unfortunately this is not per-device but global
     dnnlEngine = dnnl::engine(dnnl::engine::kind::cpu, 0);
@@ -11,7 +11,8 @@ OIDN_NAMESPACE_BEGIN
   class DNNLEngine final : public CPUEngine
   {
   public:
-    DNNLEngine(CPUDevice* device, int numThreads);
+    DNNLEngine(CPUDevice* device, int numThreads, int threadIndexOffset, int numaNode = -1,
+               tbb::task_arena* externalArena = nullptr);
 
     oidn_inline dnnl::engine& getDNNLEngine() { return dnnlEngine; }
     oidn_inline dnnl::stream& getDNNLStream() { return dnnlStream; }
@@ -30,6 +30,7 @@
 
 #include "tbb/task_scheduler_observer.h"
 #include "tbb/task_arena.h"
+#include "tbb/task_group.h"
 #include "tbb/parallel_for.h"
 #include "tbb/parallel_reduce.h"
 #include "tbb/blocked_range.h"
@@ -45,7 +46,8 @@ OIDN_NAMESPACE_BEGIN
   {
   public:
     explicit PinningObserver(const std::shared_ptr<ThreadAffinity>& affinity);
-    PinningObserver(const std::shared_ptr<ThreadAffinity>& affinity, tbb::task_arena& arena);
+    PinningObserver(const std::shared_ptr<ThreadAffinity>& affinity, tbb::task_arena& arena,
+                    int threadIndexOffset = 0);
     ~PinningObserver();
 
     void on_scheduler_entry(bool isWorker) override;
@@ -53,6 +55,7 @@ OIDN_NAMESPACE_BEGIN
 
   private:
     std::shared_ptr<ThreadAffinity> affinity;
+    int threadIndexOffset = 0; // offset of the first thread of the arena in the affinity list
   };
 
   // -----------------------------------------------------------------------------------------------
@@ -140,6 +140,10 @@ OIDN_API OIDNDevice oidnNewDeviceByLUID(const void* luid);
 OIDN_API OIDNDevice oidnNewDeviceByPCIAddress(int pciDomain, int pciBus, int pciDevice,
                                               int pciFunction);
 
+// Creates a CPU device from the specified list of TBB task arenas (pointers to tbb::task_arena
+// objects owned by the application, from the same TBB library used by Open Image Denoise).
+OIDN_API OIDNDevice oidnNewCPUDevice(void* const* taskArenas, int numArenas);
+
 #if defined(__cplusplus)
 // Creates a device from the specified list of SYCL queues.
 // The queues should belong to different SYCL sub-devices (Xe Stack/Tile) of the same SYCL
@@ -215,6 +219,13 @@ inline int oidnGetDevice1i(OIDNDevice device, const char* name)
   return oidnGetDeviceInt(device, name);
 }
 
+// Sets a string parameter of the device.
+OIDN_API void oidnSetDeviceString(OIDNDevice device, const char* name, const char* value);
+
+// Gets a string parameter of the device. The returned string is valid until the parameter is
+// changed or the device is released.
+OIDN_API const char* oidnGetDeviceString(OIDNDevice device, const char* name);
+
 // Sets the error callback function of the device.
 OIDN_API void oidnSetDeviceErrorFunction(OIDNDevice device, OIDNErrorFunction func, void* userPtr);
 
@@ -377,6 +388,7 @@ typedef enum
 {
   OIDN_QUALITY_DEFAULT  = 0, // default quality
 
+  OIDN_QUALITY_PREVIEW  = 3, // highest performance with quantized weights (for fast preview rendering)
   OIDN_QUALITY_FAST     = 4, // high performance (for interactive/real-time preview rendering)
   OIDN_QUALITY_BALANCED = 5, // balanced quality/performance (for interactive/real-time rendering)
   OIDN_QUALITY_HIGH     = 6, // high quality (for final-frame rendering)
@@ -385,6 +397,28 @@ typedef enum
 // Progress monitor callback function
 typedef bool (*OIDNProgressMonitorFunction)(void* userPtr, double n);
 
+// Profiling record of an operation, aggregated over a filter execution
+typedef struct
+{
+  const char* name;    // name of the operation
+  const char* type;    // type of the operation (e.g. "conv", "concat_conv", "input_process")
+  int count;           // number of times the operation was executed (e.g. once per tile)
+  double time;         // total wall time in seconds
+  size_t bytesRead;    // estimated total number of bytes read
+  size_t bytesWritten; // estimated total number of bytes written
+  size_t flops;        // estimated total number of floating-point operations
+} OIDNProfileRecord;
+
+// Profiling callback function, called after each filter execution if profiling is enabled for the
+// device; the records are valid only during the call
+typedef void (*OIDNProfilingFunction)(void* userPtr, const OIDNProfileRecord* records, int numRecords);
+
+// Image stream callback function, which reads numRows rows of an input image starting at row y into
+// the specified host memory, or writes the rows of the output image from it; rows are requested in
+// top-to-bottom order, and returning false cancels the filter execution
+typedef bool (*OIDNImageStreamFunction)(void* userPtr, size_t y, size_t numRows,
+                                        void* data, size_t rowByteStride);
+
 // Filter handle
 typedef struct OIDNFilterImpl* OIDNFilter;
 
@@ -413,6 +447,12 @@ OIDN_API void oidnSetSharedFilterImage(OIDNFilter filter, const char* name,
                                        size_t byteOffset,
                                        size_t pixelByteStride, size_t rowByteStride);
 
+// Sets an image parameter of the filter whose rows are streamed through a callback function in
+// horizontal bands, instead of being stored in memory.
+OIDN_API void oidnSetFilterImageStream(OIDNFilter filter, const char* name,
+                                       OIDNImageStreamFunction func, void* userPtr,
+                                       OIDNFormat format, size_t width, size_t height);
+
 // Unsets an image parameter of the filter that was previously set.
 OIDN_API void oidnUnsetFilterImage(OIDNFilter filter, const char* name);
 
@@ -496,6 +536,10 @@ inline float oidnGetFilter1f(OIDNFilter filter, const char* name)
 OIDN_API void oidnSetFilterProgressMonitorFunction(OIDNFilter filter,
                                                    OIDNProgressMonitorFunction func, void* userPtr);
 
+// Sets the profiling callback function of the filter.
+OIDN_API void oidnSetFilterProfilingFunction(OIDNFilter filter,
+                                             OIDNProfilingFunction func, void* userPtr);
+
 // Commits all previous changes to the filter.
 // Must be called before first executing the filter.
 OIDN_API void oidnCommitFilter(OIDNFilter filter);
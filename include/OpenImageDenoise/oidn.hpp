@@ -323,6 +323,7 @@ OIDN_NAMESPACE_BEGIN
   {
     Default  = OIDN_QUALITY_DEFAULT,  // default quality
 
+    Preview  = OIDN_QUALITY_PREVIEW,  // highest performance with quantized weights (for fast preview rendering)
     Fast     = OIDN_QUALITY_FAST,     // high performance (for interactive/real-time preview rendering)
     Balanced = OIDN_QUALITY_BALANCED, // balanced quality/performance (for interactive/real-time rendering)
     High     = OIDN_QUALITY_HIGH,     // high quality (for final-frame rendering)
@@ -331,6 +332,13 @@ OIDN_NAMESPACE_BEGIN
   // Progress monitor callback function
   using ProgressMonitorFunction = OIDNProgressMonitorFunction;
 
+  // Profiling record and callback function
+  using ProfileRecord = OIDNProfileRecord;
+  using ProfilingFunction = OIDNProfilingFunction;
+
+  // Image stream callback function
+  using ImageStreamFunction = OIDNImageStreamFunction;
+
   // Filter object with automatic reference counting
   class FilterRef
   {
@@ -432,6 +440,16 @@ OIDN_NAMESPACE_BEGIN
                                pixelByteStride, rowByteStride);
     }
 
+    // Sets an image parameter of the filter whose rows are streamed through a callback function in
+    // horizontal bands, instead of being stored in memory.
+    void setImageStream(const char* name,
+                        ImageStreamFunction func, void* userPtr, Format format,
+                        size_t width, size_t height)
+    {
+      oidnSetFilterImageStream(handle, name, func, userPtr, static_cast<OIDNFormat>(format),
+                               width, height);
+    }
+
     // Unsets an image parameter of the filter that was previously set.
     void unsetImage(const char* name)
     {
@@ -501,6 +519,12 @@ OIDN_NAMESPACE_BEGIN
       oidnSetFilterProgressMonitorFunction(handle, func, userPtr);
     }
 
+    // Sets the profiling callback function of the filter.
+    void setProfilingFunction(ProfilingFunction func, void* userPtr = nullptr)
+    {
+      oidnSetFilterProfilingFunction(handle, func, userPtr);
+    }
+
     // Commits all previous changes to the filter.
     void commit()
     {
@@ -700,6 +724,18 @@ OIDN_NAMESPACE_BEGIN
       oidnSetDeviceUInt(handle, name, value);
     }
 
+    // Sets a string parameter of the device.
+    void set(const char* name, const char* value)
+    {
+      oidnSetDeviceString(handle, name, value);
+    }
+
+    // Sets a string parameter of the device.
+    void set(const char* name, const std::string& value)
+    {
+      oidnSetDeviceString(handle, name, value.c_str());
+    }
+
     // Gets a parameter of the device.
     template<typename T>
     T get(const char* name) const;
@@ -820,6 +856,19 @@ OIDN_NAMESPACE_BEGIN
     return ExternalMemoryTypeFlags(oidnGetDeviceInt(handle, name));
   }
 
+  template<>
+  inline const char* DeviceRef::get(const char* name) const
+  {
+    return oidnGetDeviceString(handle, name);
+  }
+
+  template<>
+  inline std::string DeviceRef::get(const char* name) const
+  {
+    const char* str = oidnGetDeviceString(handle, name);
+    return str ? str : "";
+  }
+
   // Returns the first unqueried per-thread global error code and clears the stored error.
   inline Error getError()
   {
@@ -911,6 +960,18 @@ OIDN_NAMESPACE_BEGIN
   }
 #endif
 
+  // Creates a CPU device from the specified TBB task arena (pointer to a tbb::task_arena object).
+  inline DeviceRef newCPUDevice(void* taskArena)
+  {
+    return DeviceRef(oidnNewCPUDevice(&taskArena, 1));
+  }
+
+  // Creates a CPU device from the specified list of TBB task arenas.
+  inline DeviceRef newCPUDevice(const std::vector<void*>& taskArenas)
+  {
+    return DeviceRef(oidnNewCPUDevice(taskArenas.data(), static_cast<int>(taskArenas.size())));
+  }
+
   // Creates a device from the specified CUDA device ID and stream (null stream corresponds to the
   // default stream).
   inline DeviceRef newCUDADevice(int deviceID, cudaStream_t stream)
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+
+## Copyright 2024 Intel Corporation
+## SPDX-License-Identifier: Apache-2.0
+
+import argparse
+
+from common import *
+
+# Parse the command-line arguments
+parser = argparse.ArgumentParser(description='Benchmarks the HDR filters with the autoexposure computed before filtering and with temporal autoexposure, which reuses the input scale of the previous execution and defers the autoexposure of the current images.')
+parser.usage = '\rIntel(R) Open Image Denoise - Autoexposure Benchmark\n' + parser.format_usage()
+add_benchmark_args(parser, run='.*hdr.*')
+parser.add_argument('--device', '-d', type=str, default='default', help='device to use')
+cfg = parser.parse_args()
+
+# Runs the benchmarks with or without temporal autoexposure and returns the average time per image
+# per benchmark. Profiling is disabled because it synchronizes around every operation, which would
+# prevent the deferred autoexposure from overlapping the tiles.
+def run_autoexposure_benchmark(temporal):
+  args = ['-d', cfg.device, '-r', cfg.run, '-n', str(cfg.num_runs)]
+  if temporal:
+    args += ['--temporal']
+  return run_benchmark(cfg.build_dir, args, threads=cfg.threads)
+
+blocking = run_autoexposure_benchmark(False)
+temporal = run_autoexposure_benchmark(True)
+
+# Measure the time of the autoexposure operations separately with profiling
+_, profiles = run_benchmark(cfg.build_dir, ['-d', cfg.device, '-r', cfg.run, '-n', str(cfg.num_runs)],
+                            threads=cfg.threads, profile=True)
+
+# Print the times with the blocking and the temporal autoexposure
+for name, blocking_time in blocking.items():
+  temporal_time = temporal.get(name, 0.)
+  print(name)
+  if name in profiles:
+    print('  autoexposure : %8.2f msec' % get_op_time(profiles[name], {'autoexposure'}))
+  print('  blocking     : %8.2f msec/image' % blocking_time)
+  print('  temporal     : %8.2f msec/image (%+.1f%%)' %
+        (temporal_time, (temporal_time / blocking_time - 1.) * 100. if blocking_time > 0 else 0.))
@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+
+## Copyright 2024 Intel Corporation
+## SPDX-License-Identifier: Apache-2.0
+
+import os
+import argparse
+
+from common import *
+
+# Parse the command-line arguments
+parser = argparse.ArgumentParser(description='Benchmarks the convolutions of the CPU device with the detected and with overridden L2 cache sizes, to validate the cache blocking.')
+parser.usage = '\rIntel(R) Open Image Denoise - CPU Cache Blocking Benchmark\n' + parser.format_usage()
+add_benchmark_args(parser, run='RT.hdr_alb.1920x1080', num_runs=5)
+parser.add_argument('--cache_sizes', '-c', type=int, nargs='*', default=[256, 512, 1024, 2048, 4096], help='L2 cache sizes to compare (KB)')
+cfg = parser.parse_args()
+
+# Runs the benchmarks with the specified L2 cache size (0 = detected) and returns the total time
+# of the convolutions per benchmark
+def run_cache_benchmark(cache_size):
+  env = os.environ.copy()
+  if cache_size > 0:
+    env['OIDN_L2_CACHE_SIZE'] = str(cache_size * 1024)
+
+  _, profiles = run_benchmark(cfg.build_dir, ['-d', 'cpu', '-r', cfg.run, '-n', str(cfg.num_runs)],
+                              threads=cfg.threads, env=env, profile=True)
+  return {name : get_op_time(bench, {'conv', 'concat_conv'}) for name, bench in profiles.items()}
+
+results = {0 : run_cache_benchmark(0)}
+for cache_size in cfg.cache_sizes:
+  results[cache_size] = run_cache_benchmark(cache_size)
+
+# Print the convolution times relative to the detected cache size
+for name, detected_time in results[0].items():
+  print(name)
+  print('  detected : %8.2f msec' % detected_time)
+  for cache_size in cfg.cache_sizes:
+    time = results[cache_size][name]
+    print('  %5d KB : %8.2f msec (%+.1f%%)' % (cache_size, time, (time / detected_time - 1.) * 100.))
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+
+## Copyright 2024 Intel Corporation
+## SPDX-License-Identifier: Apache-2.0
+
+import argparse
+
+from common import *
+
+# Parse the command-line arguments
+parser = argparse.ArgumentParser(description='Benchmarks the input and output processing kernels of the CPU device for the float and half image formats, optionally comparing them to another build.')
+parser.usage = '\rIntel(R) Open Image Denoise - CPU Input/Output Processing Benchmark\n' + parser.format_usage()
+add_benchmark_args(parser)
+parser.add_argument('--baseline_dir', type=str, help='build directory of the baseline to compare to')
+parser.add_argument('--size', '-s', type=int, nargs=2, default=[1280, 720], help='image size')
+parser.add_argument('--quality', '-q', type=str, default='fast', help='filter quality')
+cfg = parser.parse_args()
+
+PROCESS_OP_TYPES = ['input_process', 'output_process']
+CONV_OP_TYPES = ['conv', 'concat_conv']
+FUSED_CONV_OP_TYPES = {'input_process' : 'input_process_conv', 'output_process' : 'conv_output_process'}
+DATA_TYPES = ['float', 'half']
+
+# Runs the benchmarks of the specified build with the specified image data type and returns the
+# time of each processing operation together with its adjacent (first or last) convolution per
+# benchmark. The processing may be fused into these convolutions, which are then profiled as a
+# single operation, so only the combined times are comparable between builds.
+def run_process_benchmark(build_dir, data_type):
+  _, profiles = run_benchmark(build_dir, ['-d', 'cpu', '-r', cfg.run, '-n', str(cfg.num_runs),
+                                          '-s', str(cfg.size[0]), str(cfg.size[1]),
+                                          '-t', data_type, '-q', cfg.quality],
+                              threads=cfg.threads, profile=True)
+
+  results = {}
+  for name, bench in profiles.items():
+    conv_op_types = CONV_OP_TYPES + list(FUSED_CONV_OP_TYPES.values())
+    convs = [op for op in bench['ops'] if op['type'] in conv_op_types]
+    for op_type, conv in zip(PROCESS_OP_TYPES, [convs[0], convs[-1]]):
+      process_msec = get_op_time(bench, {op_type})
+      fused = conv['type'] == FUSED_CONV_OP_TYPES[op_type]
+      results[(name, op_type)] = (process_msec + conv['msec'], process_msec, conv['name'], fused)
+  return results
+
+# Print the times of the processing operations including the adjacent convolutions
+for data_type in DATA_TYPES:
+  results = run_process_benchmark(cfg.build_dir, data_type)
+  baseline_results = run_process_benchmark(cfg.baseline_dir, data_type) if cfg.baseline_dir else None
+
+  for (name, op_type), (msec, process_msec, conv_name, fused) in results.items():
+    line = '%s.%s %-15s: %8.3f msec (%s %s, process %.3f msec)' % \
+           (name, data_type, op_type, msec, 'fused into' if fused else 'with', conv_name, process_msec)
+    if baseline_results and (name, op_type) in baseline_results:
+      baseline_msec = baseline_results[(name, op_type)][0]
+      if msec > 0:
+        line += ' (%.2fx vs baseline)' % (baseline_msec / msec)
+    print(line)
@@ -7,6 +7,8 @@ import subprocess
 import re
 import shutil
 import tarfile
+import tempfile
+import json
 from zipfile import ZipFile
 from urllib.request import urlretrieve
 
@@ -66,4 +68,48 @@ elif ARCH == 'aarch64':
 # Get the root directory
 root_dir = os.environ.get('OIDN_ROOT_DIR')
 if root_dir is None:
-  root_dir = os.getcwd()
\ No newline at end of file
+  root_dir = os.getcwd()
+
+# Adds the arguments shared by the oidnBenchmark scripts to the argument parser
+def add_benchmark_args(parser, run='.*', num_runs=10):
+  parser.add_argument('--build_dir', '-B', type=str, help='build directory')
+  parser.add_argument('--run', '-r', type=str, default=run, help='regular expression of the benchmarks to run')
+  parser.add_argument('--num_runs', '-n', type=int, default=num_runs, help='number of runs per benchmark')
+  parser.add_argument('--threads', type=int, help='number of threads')
+
+# Runs oidnBenchmark of the build directory (default: <root>/build) with the specified arguments and
+# returns the average time per image (msec) of each benchmark, and if requested, the per-operation
+# profiles. Profiling synchronizes around every operation, so its times include no overlap.
+def run_benchmark(build_dir, args, threads=None, env=None, profile=False):
+  if build_dir is None:
+    build_dir = os.path.join(root_dir, 'build')
+  cmd = [os.path.join(build_dir, 'oidnBenchmark')] + args
+  if threads:
+    cmd += ['--threads', str(threads)]
+
+  with tempfile.TemporaryDirectory() as temp_dir:
+    profile_filename = os.path.join(temp_dir, 'profile.json')
+    if profile:
+      cmd += ['--profile', profile_filename]
+    result = subprocess.run(cmd, env=env, stdout=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0:
+      print('Error: benchmark failed')
+      exit(1)
+
+    profiles = None
+    if profile:
+      with open(profile_filename) as f:
+        profiles = {bench['name'] : bench for bench in json.load(f)['benchmarks']}
+
+  # Parse the average times printed as '<name> ... <time> msec/image'
+  times = {}
+  for line in result.stdout.splitlines():
+    match = re.match(r'^(\S+) \.\.\..*? ([0-9.eE+-]+) msec/image', line)
+    if match:
+      times[match.group(1)] = float(match.group(2))
+
+  return (times, profiles) if profile else times
+
+# Returns the total time (msec) of the operations of a benchmark profile with the specified types
+def get_op_time(bench_profile, op_types):
+  return sum(op['msec'] for op in bench_profile['ops'] if op['type'] in op_types)
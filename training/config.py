@@ -169,6 +169,8 @@ def parse_args(cmd=None, description=None):
                         help='what to export')
     parser.add_argument('--output', '-o', type=str,
                         help='output file')
+    parser.add_argument('--quantize', action='store_true',
+                        help='quantize the convolution weights to int8 with per-output-channel scales')
 
   if cmd in {'convert_image', 'split_exr'}:
     parser.add_argument('input', type=str,
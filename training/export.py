@@ -76,10 +76,6 @@ def main():
 
       with tza.Writer(output_filename) as output_file:
         for name, value in model_state.items():
-          tensor = value.half()
-          tensor = tensor.cpu().numpy()
-          print(name, tensor.shape)
-
           if name.endswith('.weight') and len(value.shape) == 4:
             layout = 'oihw'
           elif len(value.shape) == 1:
@@ -87,7 +83,21 @@ def main():
           else:
             error('unknown state value')
 
-          output_file.write(name, tensor, layout)
+          if cfg.quantize and layout == 'oihw':
+            # Symmetric per-output-channel quantization calibrated to the maximum absolute weights
+            value = value.float()
+            scale = value.abs().amax(dim=(1, 2, 3)) / 127.
+            scale = torch.where(scale > 0, scale, torch.ones_like(scale))
+            tensor = torch.round(value / scale.view(-1, 1, 1, 1)).clamp(-127, 127).to(torch.int8)
+            tensor = tensor.cpu().numpy()
+            print(name, tensor.shape, 'int8')
+            output_file.write(name, tensor, layout)
+            output_file.write(name + '_scale', scale.cpu().numpy(), 'x')
+          else:
+            tensor = value.half()
+            tensor = tensor.cpu().numpy()
+            print(name, tensor.shape)
+            output_file.write(name, tensor, layout)
     elif cfg.target in {'onnx', 'onnx_noparams'}:
       # Export the model to ONNX
       if cfg.output: